@@ -17,6 +17,19 @@ namespace logging {
  *  ${line} - line number,
  *  ${message} - record message text.
  * 
+ *  Process constants are resolved once, when the format is set:
+ *  ${pid} - process ID,
+ *  ${hostname} - host name,
+ *  ${env:NAME} - value of the NAME environment variable,
+ *  ${name} - value of a constant registered with Formatter::set_constant.
+ * 
+ *  Variables except time can have width, alignment and truncation specification
+ *  after the colon: [[fill]align][width][.precision], for example ${level_name:<8}
+ *  or ${message:.512}. Alignment is '<' (left), '>' (right) or '^' (center),
+ *  the width and the precision are numbers of UTF-8 characters.
+ *  Numbers are aligned to the right by default, text is aligned to the left.
+ *  For ${env:NAME} the specification follows the name: ${env:NAME:>10}.
+ * 
  *  The time is formatted according to the "strftime" function,
  *  but you can also use "%f" in the time format to output milliseconds value.
  *  Time format is %Y-%m-%d %H:%M:%S.%f by default.
@@ -41,6 +54,17 @@ public:
 
     std::string get_format() const;
 
+    /**
+     * @brief Registers a process-wide constant, that can be used in a format as ${name}.
+     * 
+     *  Constants are substituted when a format is set,
+     *  so the formatters created before the call are not affected.
+     * 
+     * @param name 
+     * @param value 
+     */
+    static void set_constant(const std::string& name, const std::string& value);
+
     std::string format_record(ILogRecordData *data);
 
     virtual void format_record(ITextData *result, ILogRecordData *record, ITimeFormatter *time_fmt = nullptr) override;
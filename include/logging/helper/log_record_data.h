@@ -15,6 +15,13 @@ public:
     LogRecordData(LogLevel log_level);
     LogRecordData(LogLevel log_level, const char* file_name, int line_number);
 
+    /**
+     * @brief Copies the record, it's used to keep a record after the write call.
+     * 
+     * @param src 
+     */
+    explicit LogRecordData(const ILogRecordData &src);
+
     LogRecordData(LogRecordData &&src) noexcept;
     LogRecordData& operator = (LogRecordData &&src) noexcept;
 
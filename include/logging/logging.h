@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <string>
 
 namespace logging {
 
@@ -29,6 +30,31 @@ struct ITextData
 {
     virtual void append(const char* text) = 0;
     virtual void reserve(unsigned long size) = 0;
+
+    /**
+     * @brief Appends length bytes of text, the text may be not null-terminated.
+     */
+    virtual void append_text(const char* text, size_t length)
+    {
+        append(std::string(text, length).c_str());
+    }
+
+    /**
+     * @brief Appends the text of the record that stays valid until the sink's write returns,
+     *  so the result may reference it instead of copying.
+     */
+    virtual void append_reference(const char* text, size_t length)
+    {
+        append_text(text, length);
+    }
+
+    /**
+     * @brief Appends count copies of the fill character.
+     */
+    virtual void append_fill(char fill, size_t count)
+    {
+        append(std::string(count, fill).c_str());
+    }
 };
 
 /**
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "base.h"
+#include "drop_policy.h"
+#include <cstdint>
+
+namespace logging {
+
+/**
+ * @brief Statistics of an asynchronous sink.
+ * 
+ *  written     - number of records written to the wrapped sink,
+ *  dropped     - number of records dropped because the queue was full,
+ *  failed      - number of records whose write threw an exception,
+ *  queued      - number of records in the queue,
+ *  lag_ms      - age of the oldest queued record in milliseconds,
+ *  max_lag_ms  - maximum time from queueing a record to its write completion.
+ */
+struct AsyncSinkStats
+{
+    uint64_t written    = 0;
+    uint64_t dropped    = 0;
+    uint64_t failed     = 0;
+    size_t queued       = 0;
+    uint64_t lag_ms     = 0;
+    uint64_t max_lag_ms = 0;
+};
+
+/**
+ * @brief Sink wrapper that writes records to the wrapped sink in its own thread.
+ * 
+ *  Records are copied into a bounded queue, so a slow or stalled sink delays
+ *  only itself: when the queue is full records are dropped according to the
+ *  drop policy. The wrapped sink and the formatter of the logger must outlive
+ *  the wrapper, the logger formatter shouldn't be changed while records are queued.
+ */
+class AsyncSink : public ILogSink
+{
+public:
+
+    /**
+     * @brief Construct a new Async Sink object
+     * 
+     * @param sink          wrapped sink
+     * @param max_records   capacity of the queue
+     * @param policy        what is dropped when the queue is full
+     */
+    AsyncSink(ILogSink *sink, size_t max_records = 8192, DropPolicy policy = DropPolicy::DROP_NEWEST);
+
+    /**
+     * @brief Destroy the Async Sink object, waits until the queued records are written.
+     * 
+     */
+    ~AsyncSink();
+
+    /**
+     * @brief Waits until the queued records are written to the wrapped sink.
+     * 
+     * @param timeout_ms 
+     * @return true if all records are written
+     */
+    bool flush(unsigned int timeout_ms);
+
+    AsyncSinkStats get_stats() const;
+
+    virtual void write(ILogRecordData *record, IFormatter *logger_formatter) override;
+
+private:
+
+    class Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
+} // namespace logging
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "base.h"
+#include <cstdint>
+
+namespace logging {
+
+/**
+ * @brief Policy of tripping the circuit breaker.
+ * 
+ *  timeout_ms          - a write slower than this trips the breaker, as well as
+ *                        a write that is still running for this time when the next record comes,
+ *  error_rate          - ratio of failed writes (exceptions) among the last `window` writes
+ *                        that trips the breaker (0 - errors don't trip it),
+ *  window              - number of the latest writes the error rate is counted on,
+ *  probe_interval_ms   - time after tripping when a record is written to the sink again
+ *                        to check if it's recovered.
+ */
+struct CircuitBreakerPolicy
+{
+    unsigned int timeout_ms         = 1000;
+    double error_rate               = 0.5;
+    unsigned int window             = 20;
+    unsigned int probe_interval_ms  = 5000;
+};
+
+/**
+ * @brief State of the circuit breaker.
+ * 
+ *  CLOSED      - records are written to the sink,
+ *  OPEN        - records are diverted to the fallback,
+ *  HALF_OPEN   - a probe record is being written to the sink, the others are diverted.
+ */
+enum class CircuitState
+{
+    CLOSED,
+    OPEN,
+    HALF_OPEN,
+};
+
+/**
+ * @brief Statistics of the circuit breaker.
+ * 
+ *  trips           - number of times the breaker was opened,
+ *  diverted        - number of records passed to the fallback (or discarded without it),
+ *  failed          - number of writes that threw an exception,
+ *  max_write_us    - maximum latency of a write to the sink in microseconds.
+ */
+struct CircuitBreakerStats
+{
+    CircuitState state      = CircuitState::CLOSED;
+    uint64_t trips          = 0;
+    uint64_t diverted       = 0;
+    uint64_t failed         = 0;
+    uint64_t max_write_us   = 0;
+};
+
+/**
+ * @brief Sink wrapper that stops writing to a failing or hung sink.
+ * 
+ *  The latency and the exceptions of the writes to the wrapped sink are measured.
+ *  When a write is slower than the timeout, or errors exceed the error rate, the breaker
+ *  opens and the records go to the fallback sink (or are discarded and counted). Threads
+ *  that already entered a hung sink stay there, but the following records don't wait for it.
+ *  A record is written to the sink every probe interval, the breaker is closed when it succeeds.
+ *  Wrap the sink with AsyncSink to keep the hung writes off the logging threads too.
+ */
+class CircuitBreakerSink : public ILogSink
+{
+public:
+
+    /**
+     * @brief Construct a new Circuit Breaker Sink object
+     * 
+     * @param sink      wrapped sink
+     * @param fallback  sink that receives records while the breaker is open, nullptr - discard
+     * @param policy 
+     */
+    CircuitBreakerSink(ILogSink *sink, ILogSink *fallback = nullptr, const CircuitBreakerPolicy &policy = {});
+
+    ~CircuitBreakerSink();
+
+    CircuitBreakerStats get_stats() const;
+
+    virtual void write(ILogRecordData *record, IFormatter *logger_formatter) override;
+
+private:
+
+    class Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
+} // namespace logging
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "base.h"
+#include "flush_policy.h"
+
+namespace logging {
+
+/**
+ * @brief Standard stream of the console sink.
+ * 
+ */
+enum class ConsoleStream
+{
+    STDOUT,
+    STDERR,
+};
+
+/**
+ * @brief Log sink that writes to stdout or stderr without iostreams.
+ * 
+ *  A record is formatted into a buffer of the calling thread and written
+ *  as a whole line with write(2), so records of different threads never
+ *  interleave. When the stream is a terminal every record is written
+ *  immediately, otherwise (pipe, file) records are batched according
+ *  to the flush policy.
+ */
+class ConsoleSink : public BaseSink
+{
+public:
+
+    ConsoleSink(ConsoleStream stream = ConsoleStream::STDOUT);
+
+    template<class T>
+    ConsoleSink(T&& formatter, ConsoleStream stream = ConsoleStream::STDOUT);
+
+    ~ConsoleSink();
+
+    /**
+     * @brief Set the flush policy of the batch buffer, it isn't used for a terminal.
+     *  By default records are batched up to 64 KiB and flushed every 100 ms.
+     * 
+     * @param policy 
+     */
+    void set_flush_policy(const FlushPolicy &policy);
+
+    /**
+     * @brief Writes the batched records.
+     * 
+     */
+    void flush();
+
+    virtual void write(ILogRecordData *record, IFormatter *logger_formatter) override;
+
+private:
+
+    class Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
+template<class T>
+ConsoleSink::ConsoleSink(T&& formatter, ConsoleStream stream)
+    : ConsoleSink(stream)
+{
+    set_formatter(std::forward<T>(formatter));
+}
+
+} // namespace logging
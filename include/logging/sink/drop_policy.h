@@ -0,0 +1,15 @@
+#pragma once
+
+namespace logging {
+
+/**
+ * @brief What is dropped when a bounded queue of a sink is full.
+ * 
+ */
+enum class DropPolicy
+{
+    DROP_NEWEST,
+    DROP_OLDEST,
+};
+
+} // namespace logging
@@ -2,9 +2,81 @@
 
 #include "base.h"
 #include "file_template_exception.h"
+#include "flush_policy.h"
+#include <cstdint>
 
 namespace logging {
 
+/**
+ * @brief Policy of syncing written records to the storage device (fdatasync).
+ * 
+ *  Records are synced:
+ *  - every `records` records (0 - disabled), the writer of the record waits for the sync,
+ *  - every interval_ms milliseconds in a background thread (0 - no timer),
+ *  - when a record has sync_level or higher level, the writer waits for the sync.
+ *  Writers waiting at the same time share a single sync (group commit).
+ *  The default policy doesn't sync, syncing is supported on unix only.
+ */
+struct SyncPolicy
+{
+    unsigned int records        = 0;
+    unsigned int interval_ms    = 0;
+    LogLevel sync_level         = LogLevel::DISABLED;
+};
+
+/**
+ * @brief Statistics of syncing a file.
+ * 
+ *  commits         - number of records and FileSink::sync calls waited for a sync,
+ *  syncs           - number of fdatasync calls,
+ *  failures        - number of syncs that failed, the records of a failed sync aren't durable,
+ *  total_commit_us - total time of waiting in microseconds,
+ *  max_commit_us   - maximum time of waiting in microseconds.
+ */
+struct SyncStats
+{
+    uint64_t commits            = 0;
+    uint64_t syncs              = 0;
+    uint64_t failures           = 0;
+    uint64_t total_commit_us    = 0;
+    uint64_t max_commit_us      = 0;
+};
+
+/**
+ * @brief Type of file writer.
+ * 
+ *  STREAM  - std::fstream, available on all platforms,
+ *  FD      - POSIX file descriptor opened with O_APPEND, buffered records
+ *            are written with a single writev call (unix only, STREAM otherwise),
+ *  MMAP    - memory-mapped file extended by large preallocated chunks, records are
+ *            copied into the mapping and the file is truncated to its real length
+ *            on close (unix only, STREAM otherwise),
+ *  URING   - asynchronous writes through io_uring, detected at runtime
+ *            (linux only, FD is used when io_uring is unavailable).
+ */
+enum class FileWriter
+{
+    STREAM,
+    FD,
+    MMAP,
+    URING,
+};
+
+/**
+ * @brief Compression of rotated files.
+ * 
+ *  NONE    - files are kept as is,
+ *  GZIP    - gzip through zlib, the file gets ".gz" suffix,
+ *  ZSTD    - zstd, the file gets ".zst" suffix.
+ *  Availability depends on the build (LOGGING_WITH_ZLIB, LOGGING_WITH_ZSTD).
+ */
+enum class Compression
+{
+    NONE,
+    GZIP,
+    ZSTD,
+};
+
 /**
  * @brief Log sink that writes to a file.
  * 
@@ -16,8 +88,11 @@ namespace logging {
  *  %j - day of year (001 - 366)
  *  %W - week of the year as a decimal number (Monday is the first day of the week) (00 - 53)
  *  %H - hour as a decimal number (00 - 23)
+ *  %i - index of the file, it's increased when the file reaches the maximum size
+ *  %t - number of the writing thread, every thread writes its own files
  * 
  *  Files are rotated automatically according to the template.
+ *  With %t the settings and the limits are applied to the files of every thread separately.
  */
 class FileSink : public BaseSink
 {
@@ -46,6 +121,117 @@ public:
 
     std::string get_filename() const;
 
+    /**
+     * @brief Set the flush policy of the file buffer.
+     * 
+     * @param policy 
+     */
+    void set_flush_policy(const FlushPolicy &policy);
+
+    /**
+     * @brief Set the policy of syncing the file to the storage device.
+     * 
+     * @param policy 
+     */
+    void set_sync_policy(const SyncPolicy &policy);
+
+    /**
+     * @brief Waits until all written records are synced to the storage device.
+     * 
+     * @return false if the sync failed or isn't supported on the platform
+     */
+    bool sync();
+
+    SyncStats get_sync_stats() const;
+
+    /**
+     * @brief Set the maximum size of a file, when it's reached the writing goes on
+     *  to the file with the next %i index. The next file is created and opened
+     *  ahead of time in a background thread.
+     * 
+     * @param size  maximum file size in bytes, 0 - unlimited
+     * @throw FileTemplateException if the template doesn't contain %i
+     */
+    void set_max_file_size(uint64_t size);
+
+    /**
+     * @brief Set the maximum total size of the files matching the template,
+     *  the oldest files are removed in a background thread when it's exceeded.
+     * 
+     * @param size  maximum total size in bytes, 0 - unlimited
+     */
+    void set_max_total_size(uint64_t size);
+
+    /**
+     * @brief Set how long before the end of the current file's time period the file
+     *  of the next period is created and opened in a background thread, the writer
+     *  takes it over at the rotation without waiting for the file system.
+     * 
+     * @param lead_ms           1000 ms by default, 0 - the file is opened by the writer
+     * @param preallocate_size  disk space allocated for a new file without changing
+     *                          its size (linux only), 0 - no preallocation
+     */
+    void set_prepare_ahead(unsigned int lead_ms, uint64_t preallocate_size = 0);
+
+    /**
+     * @brief Set the type of file writer, the current file is reopened with the new writer.
+     * 
+     * @param writer 
+     */
+    void set_file_writer(FileWriter writer);
+
+    /**
+     * @brief Enables writing of the same files by several processes (unix only).
+     *  Records are appended by the FD writer in writes of whole records up to 4 KiB,
+     *  the file choice on rotation and the retention are serialized by a lock file
+     *  next to the log files. Rotated files aren't compressed in this mode,
+     *  and it can't be enabled together with the stream compression.
+     *
+     * @param enable
+     * @return true if the mode is set
+     */
+    bool set_shared_mode(bool enable);
+
+    /**
+     * @brief Set compression of the files closed by rotation. Files are compressed
+     *  in the background by a shared pool of low priority threads.
+     * 
+     * @param type 
+     * @return false if the compression isn't available in the build
+     */
+    bool set_compression(Compression type);
+
+    /**
+     * @brief Set compression of the records written to the file. Records are buffered
+     *  into independent gzip members or zstd frames, a frame is written when its records
+     *  reach the frame size or the interval elapses, instead of the flush policy's limits.
+     *  The file template should end with the compression suffix (".gz", ".zst"), rotated
+     *  files aren't compressed again. The file size limit applies to the compressed size.
+     *  Frames can't be appended atomically, so it isn't available in the shared mode.
+     * 
+     * @param type 
+     * @param frame_size        size of the records compressed into a frame
+     * @param frame_interval_ms maximum time records wait for their frame, 0 - no limit
+     * @return false if the compression isn't available in the build or the shared mode is enabled
+     */
+    bool set_stream_compression(Compression type, size_t frame_size = 64 * 1024,
+        unsigned int frame_interval_ms = 1000);
+
+    /**
+     * @brief Set the maximum number of threads compressing rotated files,
+     *  the limit is shared by all file sinks.
+     * 
+     * @param count     number of threads, 1 by default
+     */
+    static void set_compression_threads(unsigned int count);
+
+    /**
+     * @brief Writes buffered records to the file and waits for
+     *  the background file operations (rotation, compression, removal of old files).
+     * 
+     */
+    void flush();
+
     virtual void write(ILogRecordData *record, IFormatter *logger_formatter) override;
 
 private:
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "base.h"
+#include "filter_exception.h"
+
+namespace logging {
+
+/**
+ * @brief Sink wrapper that passes to the wrapped sink only the records matching a filter.
+ * 
+ *  The filter is checked on the record fields before the record is formatted.
+ *  It's an expression compiled once into a flat program:
+ * 
+ *  level <op> LEVEL            - op is one of ==, !=, <, <=, >, >=, LEVEL is a level name or a number
+ *  line <op> NUMBER            - line number of the record
+ *  file <match> "text"         - source file name of the record
+ *  message <match> "text"      - message of the record
+ * 
+ *  match is one of ==, !=, starts_with, ends_with, contains. Conditions are combined with
+ *  and (&&), or (||), not (!) and parentheses, e.g.
+ *  level >= WARNING and (file starts_with "src/net/" or message contains "timeout")
+ */
+class FilterSink : public ILogSink
+{
+public:
+
+    /**
+     * @brief Construct a new Filter Sink object
+     * 
+     * @param sink          wrapped sink
+     * @param expression    filter expression
+     * @throw FilterException if the expression is invalid
+     */
+    FilterSink(ILogSink *sink, const std::string &expression);
+
+    ~FilterSink();
+
+    /**
+     * @brief Checks if the record matches the filter.
+     * 
+     * @param record 
+     * @return true 
+     * @return false 
+     */
+    bool matches(const ILogRecordData *record) const;
+
+    virtual void write(ILogRecordData *record, IFormatter *logger_formatter) override;
+
+private:
+
+    class Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
+} // namespace logging
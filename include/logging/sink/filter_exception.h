@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+namespace logging {
+
+class FilterException : public std::exception
+{
+public:
+    template<typename T>
+    FilterException(T &&msg)
+        : desc{"logging::FilterException: "}
+    {
+        desc.append(std::forward<T>(msg));
+    }
+
+    virtual const char* what() const noexcept override;
+
+private:
+    std::string desc;
+};
+
+}
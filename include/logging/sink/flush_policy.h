@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include "../log_level.h"
+
+namespace logging {
+
+/**
+ * @brief Policy of writing buffered records to a file or a stream.
+ * 
+ *  Records are collected in a memory buffer and written out when:
+ *  - the buffer size reaches buffer_size bytes (0 - every record is written immediately),
+ *  - interval_ms milliseconds passed since the last timer flush (0 - no timer),
+ *  - a record has flush_level or higher level.
+ */
+struct FlushPolicy
+{
+    size_t buffer_size          = 0;
+    unsigned int interval_ms    = 0;
+    LogLevel flush_level        = LogLevel::ERROR;
+};
+
+} // namespace logging
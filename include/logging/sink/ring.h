@@ -0,0 +1,93 @@
+#pragma once
+
+#include "base.h"
+#include "../log_level.h"
+#include <vector>
+#include <cstdint>
+#include <limits>
+
+namespace logging {
+
+/**
+ * @brief Record read from a ring buffer.
+ * 
+ */
+struct RingRecord
+{
+    int64_t time;
+    LogLevel level;
+    std::string text;
+};
+
+/**
+ * @brief Filter of the ring buffer snapshot.
+ * 
+ *  min_level   - records of lower levels are skipped,
+ *  from_ms     - the earliest time of a record (milliseconds since epoch),
+ *  to_ms       - the latest time of a record,
+ *  max_records - maximum number of the newest records to return (0 - unlimited).
+ */
+struct RingQuery
+{
+    LogLevel min_level  = LogLevel::DEBUG;
+    int64_t from_ms     = std::numeric_limits<int64_t>::min();
+    int64_t to_ms       = std::numeric_limits<int64_t>::max();
+    size_t max_records  = 0;
+};
+
+/**
+ * @brief Log sink that keeps the latest formatted records in a fixed-size memory ring.
+ * 
+ *  Writers reserve space with a single atomic operation and never wait, the oldest
+ *  records are overwritten. A snapshot doesn't stop writers: each record is validated
+ *  by its position stamp, records overwritten while being read are skipped.
+ */
+class RingSink : public BaseSink
+{
+public:
+
+    /**
+     * @brief Construct a new Ring Sink object
+     * 
+     * @param capacity  size of the ring in bytes
+     */
+    RingSink(size_t capacity);
+
+    template<class T>
+    RingSink(T&& formatter, size_t capacity);
+
+    ~RingSink();
+
+    /**
+     * @brief Returns the records in the ring, the oldest first.
+     * 
+     * @param query 
+     * @return std::vector<RingRecord> 
+     */
+    std::vector<RingRecord> snapshot(const RingQuery &query = {}) const;
+
+    size_t capacity() const;
+
+    /**
+     * @brief Returns the number of bytes written to the ring since it was created.
+     * 
+     * @return uint64_t 
+     */
+    uint64_t written_bytes() const;
+
+    virtual void write(ILogRecordData *record, IFormatter *logger_formatter) override;
+
+private:
+
+    class Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
+template<class T>
+RingSink::RingSink(T&& formatter, size_t capacity)
+    : RingSink(capacity)
+{
+    set_formatter(std::forward<T>(formatter));
+}
+
+} // namespace logging
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "base.h"
+#include "ring.h"
+#include <vector>
+#include <cstdint>
+
+namespace logging {
+
+/**
+ * @brief Log sink that writes records into a POSIX shared-memory ring (unix only).
+ * 
+ *  The ring is created with shm_open by the first process and attached to by
+ *  the others. Producers use the lock-free protocol of RingSink and never wait
+ *  for the collector, data not collected in time is overwritten and counted
+ *  by the collector. The shared memory object isn't removed by the sink,
+ *  so the collector can drain it after the process exits.
+ */
+class ShmRingSink : public BaseSink
+{
+public:
+
+    /**
+     * @brief Construct a new Shm Ring Sink object
+     * 
+     * @param name      name of the shared memory object, e.g. "/app_worker_1"
+     * @param capacity  size of the ring in bytes
+     */
+    ShmRingSink(const std::string &name, size_t capacity);
+
+    template<class T>
+    ShmRingSink(T&& formatter, const std::string &name, size_t capacity);
+
+    ~ShmRingSink();
+
+    /**
+     * @brief Checks if the ring is created or attached.
+     * 
+     * @return true 
+     * @return false 
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Returns the number of bytes overwritten before the collector read them.
+     * 
+     * @return uint64_t 
+     */
+    uint64_t get_lost_bytes() const;
+
+    virtual void write(ILogRecordData *record, IFormatter *logger_formatter) override;
+
+private:
+
+    class Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
+template<class T>
+ShmRingSink::ShmRingSink(T&& formatter, const std::string &name, size_t capacity)
+    : ShmRingSink(name, capacity)
+{
+    set_formatter(std::forward<T>(formatter));
+}
+
+/**
+ * @brief Reader of a shared-memory ring used by collectors (unix only).
+ * 
+ *  The read position is kept in the ring, so a restarted collector
+ *  goes on from where the previous one stopped.
+ */
+class ShmRingReader
+{
+public:
+
+    ShmRingReader(const std::string &name);
+
+    ~ShmRingReader();
+
+    bool is_open() const;
+
+    /**
+     * @brief Appends the new records of the ring, updates the read position
+     *  and the overrun counter. A record whose writer didn't commit it
+     *  within a second is skipped.
+     * 
+     * @param records 
+     * @return size_t number of read records
+     */
+    size_t read(std::vector<RingRecord> &records);
+
+    uint64_t get_lost_bytes() const;
+
+    /**
+     * @brief Removes the shared memory object.
+     * 
+     * @param name 
+     * @return true on success
+     */
+    static bool remove(const std::string &name);
+
+private:
+
+    class Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
+} // namespace logging
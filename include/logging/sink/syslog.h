@@ -0,0 +1,95 @@
+#pragma once
+
+#include "base.h"
+#include "flush_policy.h"
+#include <cstdint>
+
+namespace logging {
+
+/**
+ * @brief Protocol of the syslog sink.
+ * 
+ *  RFC5424     - syslog messages for the local syslog daemon (/dev/log),
+ *  JOURNALD    - native journald protocol (/run/systemd/journal/socket),
+ *                the level, source file and line are sent as separate fields.
+ */
+enum class SyslogProtocol
+{
+    RFC5424,
+    JOURNALD,
+};
+
+/**
+ * @brief Log sink that sends records to the local syslog daemon or journald
+ *  through a unix datagram socket (unix only).
+ * 
+ *  Log levels are mapped to syslog priorities. Records are batched according
+ *  to the flush policy and sent with a single sendmmsg call (linux). The socket
+ *  is non-blocking: records that don't fit into the socket buffer, or are sent
+ *  while the daemon is unavailable, are dropped and counted.
+ */
+class SyslogSink : public BaseSink
+{
+public:
+
+    /**
+     * @brief Construct a new Syslog Sink object
+     * 
+     * @param protocol 
+     * @param app_name      application name (identifier), the process name if it's empty
+     * @param socket_path   path of the socket, the default one of the protocol if it's empty
+     */
+    SyslogSink(SyslogProtocol protocol = SyslogProtocol::RFC5424,
+        const std::string &app_name = "", const std::string &socket_path = "");
+
+    template<class T>
+    SyslogSink(T&& formatter, SyslogProtocol protocol = SyslogProtocol::RFC5424,
+        const std::string &app_name = "", const std::string &socket_path = "");
+
+    ~SyslogSink();
+
+    /**
+     * @brief Set the syslog facility, 1 (user-level messages) by default.
+     * 
+     * @param facility 
+     */
+    void set_facility(int facility);
+
+    /**
+     * @brief Set the flush policy of the batch. By default records are batched
+     *  up to 64 KiB and sent every 100 ms, ERROR and higher levels are sent immediately.
+     * 
+     * @param policy 
+     */
+    void set_flush_policy(const FlushPolicy &policy);
+
+    /**
+     * @brief Sends the batched records.
+     * 
+     */
+    void flush();
+
+    /**
+     * @brief Returns the number of records dropped since the sink was created.
+     * 
+     * @return uint64_t 
+     */
+    uint64_t get_dropped_count() const;
+
+    virtual void write(ILogRecordData *record, IFormatter *logger_formatter) override;
+
+private:
+
+    class Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
+template<class T>
+SyslogSink::SyslogSink(T&& formatter, SyslogProtocol protocol,
+    const std::string &app_name, const std::string &socket_path)
+    : SyslogSink(protocol, app_name, socket_path)
+{
+    set_formatter(std::forward<T>(formatter));
+}
+
+} // namespace logging
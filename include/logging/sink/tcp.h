@@ -0,0 +1,96 @@
+#pragma once
+
+#include "base.h"
+#include "drop_policy.h"
+#include <cstdint>
+
+namespace logging {
+
+/**
+ * @brief Framing of records in the TCP stream.
+ * 
+ *  NEWLINE         - a record is followed by '\n',
+ *  LENGTH_PREFIX   - a record is preceded by its length (4 bytes, big-endian).
+ */
+enum class TcpFraming
+{
+    NEWLINE,
+    LENGTH_PREFIX,
+};
+
+/**
+ * @brief Log sink that sends records to a collector over TCP (unix only).
+ * 
+ *  Records are queued into a bounded buffer and sent by a thread of the sink,
+ *  that coalesces them into large non-blocking writes. Producers never wait
+ *  for the network: when the buffer is full records are dropped according
+ *  to the drop policy. The connection is restored with exponential backoff,
+ *  a batch interrupted by a disconnection is sent again, so a few records
+ *  may be delivered twice.
+ */
+class TcpSink : public BaseSink
+{
+public:
+
+    TcpSink(const std::string &host, uint16_t port, TcpFraming framing = TcpFraming::NEWLINE);
+
+    template<class T>
+    TcpSink(T&& formatter, const std::string &host, uint16_t port, TcpFraming framing = TcpFraming::NEWLINE);
+
+    /**
+     * @brief Destroy the Tcp Sink object, waits up to 1 second
+     *  for the buffered records to be sent if it's connected.
+     * 
+     */
+    ~TcpSink();
+
+    /**
+     * @brief Set the buffer limit and the drop policy, 8 MiB and DROP_NEWEST by default.
+     * 
+     * @param size  maximum size of the buffered records in bytes
+     * @param policy 
+     */
+    void set_buffer_limit(size_t size, DropPolicy policy = DropPolicy::DROP_NEWEST);
+
+    /**
+     * @brief Set the reconnection delays, the delay is doubled after each
+     *  failed attempt from min_ms up to max_ms (100 ms - 10 s by default).
+     * 
+     * @param min_ms 
+     * @param max_ms 
+     */
+    void set_reconnect_delay(unsigned int min_ms, unsigned int max_ms);
+
+    /**
+     * @brief Waits until the buffered records are sent.
+     * 
+     * @param timeout_ms 
+     * @return true if all records are sent
+     */
+    bool flush(unsigned int timeout_ms);
+
+    bool is_connected() const;
+
+    /**
+     * @brief Returns the number of records dropped since the sink was created.
+     * 
+     * @return uint64_t 
+     */
+    uint64_t get_dropped_count() const;
+
+    virtual void write(ILogRecordData *record, IFormatter *logger_formatter) override;
+
+private:
+
+    class Impl;
+    std::unique_ptr<Impl> pimpl;
+};
+
+template<class T>
+TcpSink::TcpSink(T&& formatter, const std::string &host, uint16_t port, TcpFraming framing)
+    : TcpSink(host, port, framing)
+{
+    set_formatter(std::forward<T>(formatter));
+}
+
+} // namespace logging
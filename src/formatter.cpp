@@ -2,10 +2,22 @@
 #include <stdio.h>
 #include <vector>
 #include <numeric>
+#include <algorithm>
 #include <cstring>
+#include <cstdlib>
+#include <charconv>
+#include <map>
+#include <mutex>
 #include <logging/log_level.h>
 #include <logging/helper/datetime.h>
 
+#if defined(_WIN32)
+#   include <process.h>
+#   include <windows.h>
+#else
+#   include <unistd.h>
+#endif
+
 namespace logging {
 
 
@@ -24,6 +36,16 @@ struct TextData : public ITextData
     {
         data.reserve(size);
     }
+
+    virtual void append_text(const char* text, size_t length) override
+    {
+        data.append(text, length);
+    }
+
+    virtual void append_fill(char fill, size_t count) override
+    {
+        data.append(count, fill);
+    }
 };
 
 bool is_allowed_fmt_char(char c) {
@@ -181,6 +203,214 @@ void format_date_and_time(ITextData *target, const std::string& format, const st
     }
 }
 
+/**
+ * @brief Width, alignment and truncation of a format element: [[fill]align][width][.precision]
+ * 
+ *  The width and the precision are numbers of characters (UTF-8 code points).
+ */
+struct FormatSpec
+{
+    char fill = ' ';
+    char align = 0;
+    std::size_t width = 0;
+    std::size_t precision = std::string::npos;
+
+    bool is_default() const
+    {
+        return width == 0 && precision == std::string::npos;
+    }
+};
+
+bool is_align_char(char c)
+{
+    return c == '<' || c == '>' || c == '^';
+}
+
+bool parse_size(const char *&str, const char *end, std::size_t &result)
+{
+    auto res = std::from_chars(str, end, result);
+    if (res.ec != std::errc{} || res.ptr == str) {
+        return false;
+    }
+    str = res.ptr;
+    return true;
+}
+
+/**
+ * @brief Parses format specification, returns default one on error.
+ * 
+ * @param spec 
+ * @return FormatSpec 
+ */
+FormatSpec parse_format_spec(const std::string& spec)
+{
+    FormatSpec result;
+    const char *p = spec.c_str();
+    const char *end = p + spec.length();
+
+    if (spec.length() > 1 && is_align_char(p[1])) {
+        result.fill = p[0];
+        result.align = p[1];
+        p += 2;
+    } else if (p != end && is_align_char(p[0])) {
+        result.align = p[0];
+        ++p;
+    }
+    if (p != end && *p != '.' && !parse_size(p, end, result.width)) {
+        return {};
+    }
+    if (p != end && *p == '.') {
+        ++p;
+        if (!parse_size(p, end, result.precision)) {
+            return {};
+        }
+    }
+    if (p != end) {
+        return {};
+    }
+    return result;
+}
+
+inline bool is_utf8_continuation(char c)
+{
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+/**
+ * @brief Finds the byte length of the first max_chars characters of UTF-8 text.
+ * 
+ * @param text 
+ * @param length        text length in bytes
+ * @param max_chars     
+ * @param chars         number of characters in the result
+ * @return std::size_t 
+ */
+std::size_t utf8_prefix(const char *text, std::size_t length, std::size_t max_chars, std::size_t &chars)
+{
+    chars = 0;
+    for (std::size_t i = 0; i < length; ++i) {
+        if (!is_utf8_continuation(text[i])) {
+            if (chars == max_chars) {
+                return i;
+            }
+            ++chars;
+        }
+    }
+    return length;
+}
+
+/**
+ * @brief Appends text to the target applying the format specification.
+ *  Padding is written directly into the target.
+ * 
+ * @param target 
+ * @param text 
+ * @param length 
+ * @param spec 
+ * @param default_align     alignment used when the spec doesn't define one
+ */
+void append_aligned(ITextData *target, const char *text, std::size_t length, const FormatSpec& spec, char default_align = '<')
+{
+    std::size_t chars = 0;
+    length = utf8_prefix(text, length, spec.precision, chars);
+
+    std::size_t pad = spec.width > chars ? spec.width - chars : 0;
+    std::size_t left = 0;
+    switch (spec.align ? spec.align : default_align) {
+        case '>': left = pad; break;
+        case '^': left = pad / 2; break;
+    }
+    if (left) {
+        target->append_fill(spec.fill, left);
+    }
+    target->append_text(text, length);
+    if (pad > left) {
+        target->append_fill(spec.fill, pad - left);
+    }
+}
+
+void append_number(ITextData *target, int value, const FormatSpec& spec)
+{
+    char str[16];
+    auto res = std::to_chars(str, str + sizeof(str), value);
+    append_aligned(target, str, res.ptr - str, spec, '>');
+}
+
+/**
+ * @brief Registry of user-defined constants, shared by all formatters.
+ * 
+ */
+struct ConstantRegistry
+{
+    std::mutex mutex;
+    std::map<std::string, std::string> values;
+
+    static ConstantRegistry& instance()
+    {
+        static ConstantRegistry registry;
+        return registry;
+    }
+};
+
+std::string process_id()
+{
+#if defined(_WIN32)
+    return std::to_string(_getpid());
+#else
+    return std::to_string(getpid());
+#endif
+}
+
+std::string host_name()
+{
+    char name[256] = {0};
+#if defined(_WIN32)
+    DWORD size = sizeof(name);
+    if (!GetComputerNameA(name, &size)) {
+        return "";
+    }
+#else
+    if (gethostname(name, sizeof(name) - 1) != 0) {
+        return "";
+    }
+#endif
+    return name;
+}
+
+std::string env_value(const std::string& name)
+{
+    const char* value = std::getenv(name.c_str());
+    return value ? value : "";
+}
+
+/**
+ * @brief Resolves a process-constant format element.
+ * 
+ * @param element   element name
+ * @param arg       element argument (${env:NAME})
+ * @param value     resolved value
+ * @return true if the element is a constant
+ */
+bool resolve_constant(const std::string& element, const std::string& arg, std::string& value)
+{
+    if (element == "pid") {
+        value = process_id();
+    } else if (element == "hostname") {
+        value = host_name();
+    } else if (element == "env") {
+        value = env_value(arg);
+    } else {
+        auto& registry = ConstantRegistry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        auto it = registry.values.find(element);
+        if (it == registry.values.end()) {
+            return false;
+        }
+        value = it->second;
+    }
+    return true;
+}
+
 std::tm ms_to_tm(int64_t ms)
 {
     std::tm datetime;
@@ -222,6 +452,7 @@ struct FormatUnit
     FormatUnitType type;
     std::string text;
     bool is_msec;
+    FormatSpec spec;
     
     FormatUnit(
         FormatUnitType type,
@@ -232,16 +463,22 @@ struct FormatUnit
         , is_msec(is_msec)
     { }
 
+    FormatUnit(FormatUnitType type, const FormatSpec& spec)
+        : type(type)
+        , is_msec(false)
+        , spec(spec)
+    { }
+
     std::size_t get_length() const
     {
         switch (type) {
             case FormatUnitType::TIME:          return calc_formatted_time_length(text, is_msec);
-            case FormatUnitType::LEVEL:         return 3;
-            case FormatUnitType::LEVEL_NAME:    return 8;
-            case FormatUnitType::FILE:          return 0;
-            case FormatUnitType::LINE:          return 4;
+            case FormatUnitType::LEVEL:         return std::max<std::size_t>(3, spec.width);
+            case FormatUnitType::LEVEL_NAME:    return std::max<std::size_t>(8, spec.width);
+            case FormatUnitType::FILE:          return spec.width;
+            case FormatUnitType::LINE:          return std::max<std::size_t>(4, spec.width);
             case FormatUnitType::TEXT:          return text.length();
-            case FormatUnitType::MESSAGE:       return 0;
+            case FormatUnitType::MESSAGE:       return spec.width;
         }
         return 0;
     }
@@ -296,7 +533,7 @@ struct Formatter::Impl
         while (i < len) {
             if (format[i] == '$' && i + 1 < len && format[i + 1] == '{') {
                 if (i > start) {
-                    format_units.emplace_back(FormatUnitType::TEXT, format.substr(start, i - start));
+                    add_text_unit(format.substr(start, i - start));
                 }
                 start = i + 2;
                 i = format.find_first_of('}', i + 2);
@@ -306,13 +543,14 @@ struct Formatter::Impl
                     is_message = add_format_unit(format.substr(start, i - start)) || is_message;
                     i++;
                     start = i;
+                    continue;
                 }
             }
             i++;
         }
 
         if (i > start) {
-            format_units.emplace_back(FormatUnitType::TEXT, format.substr(start, i - start));
+            add_text_unit(format.substr(start, i - start));
         }
 
         if (!is_message) {
@@ -327,6 +565,23 @@ struct Formatter::Impl
         );
     }
 
+    /**
+     * @brief Adds text to format_units, merges it with the previous TEXT unit
+     * 
+     * @param text 
+     */
+    void add_text_unit(const std::string& text)
+    {
+        if (text.empty()) {
+            return;
+        }
+        if (!format_units.empty() && format_units.back().type == FormatUnitType::TEXT) {
+            format_units.back().text.append(text);
+        } else {
+            format_units.emplace_back(FormatUnitType::TEXT, text);
+        }
+    }
+
     /**
      * @brief Adds format element to format_units
      * 
@@ -346,17 +601,30 @@ struct Formatter::Impl
             bool has_ms = prepare_time_format(element_fmt);
             format_units.emplace_back(FormatUnitType::TIME, element_fmt, has_ms);
         } else if (element == "level_name") {
-            format_units.emplace_back(FormatUnitType::LEVEL_NAME);
+            format_units.emplace_back(FormatUnitType::LEVEL_NAME, parse_format_spec(element_fmt));
         } else if (element == "level") {
-            format_units.emplace_back(FormatUnitType::LEVEL);
+            format_units.emplace_back(FormatUnitType::LEVEL, parse_format_spec(element_fmt));
         } else if (element == "file") {
-            format_units.emplace_back(FormatUnitType::FILE);
+            format_units.emplace_back(FormatUnitType::FILE, parse_format_spec(element_fmt));
             has_file = true;
         } else if (element == "line") {
-            format_units.emplace_back(FormatUnitType::LINE);
+            format_units.emplace_back(FormatUnitType::LINE, parse_format_spec(element_fmt));
         } else if (element == "message") {
-            format_units.emplace_back(FormatUnitType::MESSAGE);
+            format_units.emplace_back(FormatUnitType::MESSAGE, parse_format_spec(element_fmt));
             return true;
+        } else {
+            std::string arg;
+            if (element == "env") {
+                size_t spec_pos = element_fmt.find_first_of(':');
+                arg = element_fmt.substr(0, spec_pos);
+                element_fmt = spec_pos != std::string::npos ? element_fmt.substr(spec_pos + 1) : "";
+            }
+            std::string value;
+            if (resolve_constant(element, arg, value)) {
+                TextData text;
+                append_aligned(&text, value.c_str(), value.length(), parse_format_spec(element_fmt));
+                add_text_unit(text.data);
+            }
         }
         return false;
     }
@@ -417,6 +685,13 @@ void Formatter::set_format(const std::string& format)
     }
 }
 
+void Formatter::set_constant(const std::string& name, const std::string& value)
+{
+    auto& registry = ConstantRegistry::instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.values[name] = value;
+}
+
 std::string Formatter::format_record(ILogRecordData* record)
 {
     TextData result;
@@ -448,23 +723,43 @@ void Formatter::format_record(ITextData *result, ILogRecordData *record, ITimeFo
             break;
                 
         case FormatUnitType::LEVEL:
-            result->append(std::to_string(static_cast<int>(record->get_level())).c_str());
+            append_number(result, static_cast<int>(record->get_level()), unit.spec);
             break;
 
         case FormatUnitType::LEVEL_NAME:
-            result->append(log_level_name(record->get_level()));
+            if (unit.spec.is_default()) {
+                result->append(log_level_name(record->get_level()));
+            } else {
+                const char *name = log_level_name(record->get_level());
+                append_aligned(result, name, strlen(name), unit.spec);
+            }
             break;
                 
         case FormatUnitType::FILE:
-            result->append(record->get_file_name());
+            if (unit.spec.is_default()) {
+                result->append(record->get_file_name());
+            } else {
+                const char *name = record->get_file_name();
+                append_aligned(result, name, strlen(name), unit.spec);
+            }
             break;
                 
         case FormatUnitType::LINE:
-            result->append(std::to_string(record->get_line_number()).c_str());
+            append_number(result, record->get_line_number(), unit.spec);
             break;
 
         case FormatUnitType::MESSAGE:
-            result->append(record->get_data());   
+            if (unit.spec.is_default()) {
+                result->append_reference(record->get_data(),
+                    static_cast<std::size_t>(record->get_data_length(false)));
+            } else {
+                append_aligned(
+                    result,
+                    record->get_data(),
+                    static_cast<std::size_t>(record->get_data_length(false)),
+                    unit.spec
+                );
+            }
             break;
         }
     }
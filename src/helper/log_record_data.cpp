@@ -24,6 +24,14 @@ LogRecordData::LogRecordData(LogLevel log_level, const char* file_name, int line
     }
 }
 
+LogRecordData::LogRecordData(const ILogRecordData &src)
+    : milliseconds(src.get_time())
+    , line_number(src.get_line_number())
+    , file_name(src.get_file_name())
+    , data(src.get_data(), static_cast<size_t>(src.get_data_length(false)))
+    , log_level(src.get_level())
+{ }
+
 LogRecordData::LogRecordData(LogRecordData &&rhs) noexcept
 {
     *this = std::move(rhs);
@@ -0,0 +1,191 @@
+#include <logging/sink/async.h>
+#include <logging/helper/log_record_data.h>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <condition_variable>
+
+namespace logging {
+
+/*
+ *
+ *  AsyncSink::Impl class
+ *
+ */
+
+class AsyncSink::Impl
+{
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    struct QueuedRecord
+    {
+        LogRecordData record;
+        IFormatter *formatter;
+        Clock::time_point queued;
+    };
+
+    ILogSink *sink;
+    size_t max_records;
+    DropPolicy drop_policy;
+
+    mutable std::mutex mutex;
+    std::condition_variable queue_cv;
+    std::condition_variable written_cv;
+    std::deque<QueuedRecord> queue;
+    size_t writing;
+    Clock::time_point writing_queued;
+    bool stopping;
+    uint64_t written;
+    uint64_t dropped;
+    uint64_t failed;
+    uint64_t max_lag_ms;
+    std::thread thread;
+
+    Impl(ILogSink *sink, size_t max_records, DropPolicy policy);
+    ~Impl();
+    void push(ILogRecordData *record, IFormatter *formatter);
+    bool flush(unsigned int timeout_ms);
+    AsyncSinkStats get_stats() const;
+    void run();
+};
+
+AsyncSink::Impl::Impl(ILogSink *sink, size_t max_records, DropPolicy policy)
+    : sink{sink}
+    , max_records{std::max<size_t>(max_records, 1)}
+    , drop_policy{policy}
+    , writing{0}
+    , stopping{false}
+    , written{0}
+    , dropped{0}
+    , failed{0}
+    , max_lag_ms{0}
+    , thread{[this]() { run(); }}
+{ }
+
+AsyncSink::Impl::~Impl()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queue_cv.notify_one();
+    thread.join();
+}
+
+void AsyncSink::Impl::push(ILogRecordData *record, IFormatter *formatter)
+{
+    QueuedRecord queued{LogRecordData{*record}, formatter, Clock::now()};
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queue.size() >= max_records) {
+            ++dropped;
+            if (drop_policy == DropPolicy::DROP_NEWEST) {
+                return;
+            }
+            queue.pop_front();
+        }
+        queue.push_back(std::move(queued));
+    }
+    queue_cv.notify_one();
+}
+
+bool AsyncSink::Impl::flush(unsigned int timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    return written_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]() {
+        return queue.empty() && !writing;
+    });
+}
+
+AsyncSinkStats AsyncSink::Impl::get_stats() const
+{
+    AsyncSinkStats stats;
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.written = written;
+    stats.dropped = dropped;
+    stats.failed = failed;
+    stats.queued = queue.size() + writing;
+    stats.max_lag_ms = max_lag_ms;
+    if (writing || !queue.empty()) {
+        // the batch being written is older than the queue
+        auto oldest = writing ? writing_queued : queue.front().queued;
+        stats.lag_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            Clock::now() - oldest).count());
+    }
+    return stats;
+}
+
+/**
+ * @brief Writes the queued records to the wrapped sink, the queue isn't locked while writing.
+ *  Exceptions of the sink are counted, the thread goes on with the next records.
+ * 
+ */
+void AsyncSink::Impl::run()
+{
+    std::deque<QueuedRecord> batch;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        queue_cv.wait(lock, [this]() { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            break;
+        }
+        batch.swap(queue);
+        writing = batch.size();
+        writing_queued = batch.front().queued;
+        lock.unlock();
+
+        uint64_t batch_lag_ms = 0;
+        uint64_t batch_failed = 0;
+        for (auto &queued : batch) {
+            try {
+                sink->write(&queued.record, queued.formatter);
+            } catch (...) {
+                ++batch_failed;
+            }
+            auto lag = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                Clock::now() - queued.queued).count());
+            batch_lag_ms = std::max(batch_lag_ms, lag);
+        }
+
+        lock.lock();
+        written += batch.size() - batch_failed;
+        failed += batch_failed;
+        writing = 0;
+        max_lag_ms = std::max(max_lag_ms, batch_lag_ms);
+        batch.clear();
+        written_cv.notify_all();
+    }
+}
+
+/*
+ *
+ *  AsyncSink class
+ *
+ */
+
+AsyncSink::AsyncSink(ILogSink *sink, size_t max_records, DropPolicy policy)
+    : pimpl(std::make_unique<Impl>(sink, max_records, policy))
+{ }
+
+AsyncSink::~AsyncSink() = default;
+
+bool AsyncSink::flush(unsigned int timeout_ms)
+{
+    return pimpl->flush(timeout_ms);
+}
+
+AsyncSinkStats AsyncSink::get_stats() const
+{
+    return pimpl->get_stats();
+}
+
+void AsyncSink::write(ILogRecordData *record, IFormatter *logger_formatter)
+{
+    pimpl->push(record, logger_formatter);
+}
+
+} // namespace logging
@@ -0,0 +1,179 @@
+#include <logging/sink/circuit_breaker.h>
+#include <set>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+namespace logging {
+
+/*
+ *
+ *  CircuitBreakerSink::Impl class
+ *
+ */
+
+class CircuitBreakerSink::Impl
+{
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    ILogSink *sink;
+    ILogSink *fallback;
+    CircuitBreakerPolicy policy;
+
+    mutable std::mutex mutex;
+    CircuitState state;
+    Clock::time_point probe_time;
+    std::multiset<Clock::time_point> running_writes;
+    std::vector<bool> results;
+    size_t result_pos;
+    size_t result_count;
+    size_t error_count;
+    CircuitBreakerStats stats;
+
+    Impl(ILogSink *sink, ILogSink *fallback, const CircuitBreakerPolicy &policy);
+    void write(ILogRecordData *record, IFormatter *formatter);
+    void trip(Clock::time_point now);
+    bool add_result(bool failed);
+};
+
+CircuitBreakerSink::Impl::Impl(ILogSink *sink, ILogSink *fallback, const CircuitBreakerPolicy &policy)
+    : sink{sink}
+    , fallback{fallback}
+    , policy{policy}
+    , state{CircuitState::CLOSED}
+    , results(std::max(policy.window, 1u), false)
+    , result_pos{0}
+    , result_count{0}
+    , error_count{0}
+{ }
+
+/**
+ * @brief Opens the breaker, the sink is probed after the probe interval.
+ * 
+ * @param now 
+ */
+void CircuitBreakerSink::Impl::trip(Clock::time_point now)
+{
+    if (state != CircuitState::OPEN) {
+        ++stats.trips;
+    }
+    state = CircuitState::OPEN;
+    probe_time = now + std::chrono::milliseconds(policy.probe_interval_ms);
+    result_pos = result_count = error_count = 0;
+}
+
+/**
+ * @brief Adds the result of a write to the window.
+ * 
+ * @param failed 
+ * @return true if the error rate is exceeded
+ */
+bool CircuitBreakerSink::Impl::add_result(bool failed)
+{
+    if (result_count == results.size()) {
+        error_count -= results[result_pos] ? 1 : 0;
+    } else {
+        ++result_count;
+    }
+    results[result_pos] = failed;
+    error_count += failed ? 1 : 0;
+    result_pos = (result_pos + 1) % results.size();
+
+    return policy.error_rate > 0 && result_count == results.size()
+        && static_cast<double>(error_count) >= policy.error_rate * static_cast<double>(results.size());
+}
+
+void CircuitBreakerSink::Impl::write(ILogRecordData *record, IFormatter *formatter)
+{
+    auto timeout = std::chrono::milliseconds(policy.timeout_ms);
+    auto start = Clock::now();
+    bool probe = false;
+    bool divert = false;
+    std::multiset<Clock::time_point>::iterator running;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (state != CircuitState::OPEN && !running_writes.empty() && start - *running_writes.begin() > timeout) {
+            // a write hangs in the sink
+            trip(start);
+        }
+        if (state == CircuitState::OPEN && start >= probe_time && running_writes.empty()) {
+            state = CircuitState::HALF_OPEN;
+            probe = true;
+        }
+        if (state != CircuitState::CLOSED && !probe) {
+            ++stats.diverted;
+            divert = true;
+        } else {
+            running = running_writes.insert(start);
+        }
+    }
+
+    if (divert) {
+        if (fallback) {
+            fallback->write(record, formatter);
+        }
+        return;
+    }
+
+    bool failed = false;
+    try {
+        sink->write(record, formatter);
+    } catch (...) {
+        failed = true;
+    }
+    auto end = Clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running_writes.erase(running);
+        auto latency = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+        stats.max_write_us = std::max(stats.max_write_us, latency);
+        stats.failed += failed ? 1 : 0;
+        stats.diverted += failed ? 1 : 0;
+
+        bool slow = end - start > timeout;
+        if (probe) {
+            if (failed || slow) {
+                trip(end);
+            } else {
+                state = CircuitState::CLOSED;
+            }
+        } else if (state == CircuitState::CLOSED && (add_result(failed) || slow)) {
+            trip(end);
+        }
+    }
+
+    if (failed && fallback) {
+        fallback->write(record, formatter);
+    }
+}
+
+/*
+ *
+ *  CircuitBreakerSink class
+ *
+ */
+
+CircuitBreakerSink::CircuitBreakerSink(ILogSink *sink, ILogSink *fallback, const CircuitBreakerPolicy &policy)
+    : pimpl(std::make_unique<Impl>(sink, fallback, policy))
+{ }
+
+CircuitBreakerSink::~CircuitBreakerSink() = default;
+
+CircuitBreakerStats CircuitBreakerSink::get_stats() const
+{
+    std::lock_guard<std::mutex> lock(pimpl->mutex);
+    CircuitBreakerStats stats = pimpl->stats;
+    stats.state = pimpl->state;
+    return stats;
+}
+
+void CircuitBreakerSink::write(ILogRecordData *record, IFormatter *logger_formatter)
+{
+    pimpl->write(record, logger_formatter);
+}
+
+} // namespace logging
@@ -0,0 +1,168 @@
+#include <logging/sink/console.h>
+#include <mutex>
+#include <string>
+#include "helpers/periodic_timer.h"
+#include "helpers/string_text_data.h"
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include "helpers/fd_io.h"
+#endif
+
+namespace logging {
+
+constexpr size_t default_batch_size = 64 * 1024;
+constexpr unsigned int default_batch_interval_ms = 100;
+
+static bool is_terminal(int fd)
+{
+#ifdef _WIN32
+    return _isatty(fd) != 0;
+#else
+    return isatty(fd) != 0;
+#endif
+}
+
+static void write_console(int fd, const char *data, size_t size)
+{
+#ifdef _WIN32
+    while (size) {
+        int res = _write(fd, data, static_cast<unsigned int>(size));
+        if (res <= 0) {
+            break;
+        }
+        data += res;
+        size -= res;
+    }
+#else
+    write_all(fd, data, size);
+#endif
+}
+
+/*
+ *
+ *  ConsoleSink::Impl class
+ *
+ */
+
+class ConsoleSink::Impl
+{
+public:
+
+    int fd;
+    bool terminal;
+    FlushPolicy flush_policy;
+    std::mutex mutex;
+    std::string batch;
+    PeriodicTimer flush_timer;
+
+    Impl(ConsoleStream stream);
+    ~Impl();
+    void write_line(const std::string &line, LogLevel level);
+    void set_flush_policy(const FlushPolicy &policy);
+    void flush();
+};
+
+ConsoleSink::Impl::Impl(ConsoleStream stream)
+    : fd{stream == ConsoleStream::STDERR ? 2 : 1}
+    , terminal{is_terminal(fd)}
+{
+    if (!terminal) {
+        set_flush_policy({default_batch_size, default_batch_interval_ms, LogLevel::ERROR});
+    }
+}
+
+ConsoleSink::Impl::~Impl()
+{
+    flush_timer.stop();
+    flush();
+}
+
+void ConsoleSink::Impl::set_flush_policy(const FlushPolicy &policy)
+{
+    flush_timer.stop();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        flush_policy = policy;
+        if (batch.length() >= flush_policy.buffer_size) {
+            write_console(fd, batch.data(), batch.length());
+            batch.clear();
+        }
+    }
+    if (!terminal && flush_policy.interval_ms) {
+        flush_timer.start(flush_policy.interval_ms, [this]() { flush(); });
+    }
+}
+
+void ConsoleSink::Impl::flush()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!batch.empty()) {
+        write_console(fd, batch.data(), batch.length());
+        batch.clear();
+    }
+}
+
+/**
+ * @brief Writes the line (with the line separator) directly or appends it to the batch.
+ * 
+ * @param line 
+ * @param level 
+ */
+void ConsoleSink::Impl::write_line(const std::string &line, LogLevel level)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (terminal || (batch.empty() && !flush_policy.buffer_size)) {
+        write_console(fd, line.data(), line.length());
+        return;
+    }
+
+    batch.append(line);
+    if (batch.length() >= flush_policy.buffer_size || level >= flush_policy.flush_level) {
+        write_console(fd, batch.data(), batch.length());
+        batch.clear();
+    }
+}
+
+/*
+ *
+ *  ConsoleSink class
+ *
+ */
+
+ConsoleSink::ConsoleSink(ConsoleStream stream)
+    : pimpl(std::make_unique<Impl>(stream))
+{ }
+
+ConsoleSink::~ConsoleSink() = default;
+
+void ConsoleSink::set_flush_policy(const FlushPolicy &policy)
+{
+    pimpl->set_flush_policy(policy);
+}
+
+void ConsoleSink::flush()
+{
+    pimpl->flush();
+}
+
+void ConsoleSink::write(ILogRecordData *record, IFormatter *logger_formatter)
+{
+    // the buffer keeps its capacity between records of the thread
+    thread_local std::string line;
+    line.clear();
+
+    IFormatter *formatter = sink_formatter ? static_cast<IFormatter*>(sink_formatter.get()) : logger_formatter;
+    if (formatter) {
+        StringTextData data{line};
+        formatter->format_record(&data, record);
+    } else {
+        line.append(record->get_data());
+    }
+    line.append(1, '\n');
+
+    pimpl->write_line(line, record->get_level());
+}
+
+} // namespace logging
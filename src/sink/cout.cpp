@@ -1,5 +1,7 @@
 #include <logging/sink/cout.h>
 #include <iostream>
+#include <iterator>
+#include <algorithm>
 #include <logging/formatter.h>
 
 namespace logging {
@@ -19,6 +21,16 @@ struct CoutData : public ITextData
 
     virtual void reserve(unsigned long size) override
     { }
+
+    virtual void append_text(const char* text, size_t length) override
+    {
+        std::cout.write(text, length);
+    }
+
+    virtual void append_fill(char fill, size_t count) override
+    {
+        std::fill_n(std::ostreambuf_iterator<char>(std::cout), count, fill);
+    }
 };
 
 void CoutSink::write(ILogRecordData *record, IFormatter *logger_formatter)
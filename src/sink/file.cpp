@@ -1,16 +1,61 @@
 #include <logging/sink/file.h>
 #include <vector>
 #include <ctime>
-#include <limits>
 #include <iostream>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <set>
+#include <limits>
+#include <condition_variable>
 #include <string.h>
 #include <logging/helper/datetime.h>
 #include "helpers/filename_template.h"
 #include "helpers/file_writer.h"
-#include "helpers/convert_str.h"
+#include "helpers/background_worker.h"
+#include "helpers/file_retention.h"
+#include "helpers/file_compressor.h"
+#include "helpers/periodic_timer.h"
+#include "helpers/deadline_timer.h"
+#ifdef __unix__
+#include <unistd.h>
+#include "helpers/fd_io.h"
+#include "helpers/file_lock.h"
+#endif
 
 namespace logging {
 
+/**
+ * @brief Maximum size of a single write in the shared mode, appends
+ *  up to the page size aren't interleaved with writes of other processes.
+ */
+constexpr size_t shared_write_size = 4096;
+
+/**
+ * @brief Maximum number of records written by a combining thread,
+ *  the rest is left to the next combiner.
+ */
+constexpr size_t max_combined_records = 1024;
+
+/**
+ * @brief Default time before the end of the file's time period
+ *  when the file of the next period is opened in the background.
+ */
+constexpr unsigned int default_prepare_ahead_ms = 1000;
+
+/**
+ * @brief Default size of the records compressed into a frame of the stream compression.
+ */
+constexpr size_t default_frame_size = 64 * 1024;
+
+/**
+ * @brief Default maximum time records wait for their compressed frame.
+ */
+constexpr unsigned int default_frame_interval_ms = 1000;
+
 /*
  *
  *  FileSink::Impl class
@@ -22,24 +67,178 @@ class FileSink::Impl
 public:
 
     FilenameTemplate filename_template;
+    std::string lock_name;
     unsigned int max_num_files;
     std::unique_ptr<LogFile> file;
-    std::tm last_record_tm;
+    std::tm file_tm;
+    RotationPeriod rotation_period;
+    FlushPolicy flush_policy;
+    FileWriter file_writer;
+    std::mutex file_mutex;
+
+    uint64_t max_file_size;
+    uint64_t max_total_size;
+    uint64_t file_size;
+    unsigned int file_index;
+    FileRetention retention;
+    Compression compression;
+    Compression stream_compression;
+    size_t frame_size;
+    unsigned int frame_interval_ms;
+    bool shared_mode;
+    std::shared_ptr<FileCompressor> compressor;
+
+    PeriodicTimer flush_timer;
+
+    SyncPolicy sync_policy;
+    unsigned int unsynced_records;
+    uint64_t written_seq;
+    std::mutex sync_mutex;
+    std::condition_variable sync_cv;
+    uint64_t synced_seq;
+    uint64_t failed_seq;    // the last record of the latest failed sync
+    bool syncing;
+    SyncStats sync_stats;
+    PeriodicTimer sync_timer;
+
+    /**
+     * @brief The next file opened ahead of time for size or time rotation.
+     * 
+     */
+    struct PreparedFile
+    {
+        std::string filename;
+        std::unique_ptr<LogFile> file;
+        uint64_t size = 0;
+        bool created = false;
+        unsigned int index = 0;
+        int64_t period_start = 0;
+        FileWriter writer = FileWriter::STREAM;
+        Compression stream = Compression::NONE;
+    };
+
+    std::mutex next_file_mutex;
+    PreparedFile next_file;
+    PreparedFile period_file;
+    std::string active_filename;    // prepared files of this name are closed but never removed
+    unsigned int prepare_ahead_ms;
+    uint64_t preallocate_size;
+    DeadlineTimer prepare_timer;
+
+    /**
+     * @brief A formatted record published for writing by the combining thread.
+     *  Its thread waits until the record is written, so the referenced texts stay valid.
+     */
+    struct PendingRecord
+    {
+        FileRecordData data;
+        int64_t time;
+        LogLevel level;
+        uint64_t seq = 0;
+        std::exception_ptr error;
+        bool done = false;
+        PendingRecord *next = nullptr;
+    };
+
+    std::atomic<PendingRecord*> pending_records;
+    std::mutex combine_mutex;
+    std::condition_variable combine_cv;
+    bool combining;
+    uint64_t combine_generation;
+
+    /**
+     * @brief Sinks of the threads' files when the template has %t,
+     *  this object keeps the settings only.
+     */
+    bool sharded;
+    uint64_t sink_id;
+    std::mutex shards_mutex;
+    std::map<unsigned int, std::unique_ptr<Impl>> shards;
+
+    /**
+     * @brief Numbers of the threads used for %t and the sharded sinks. A number
+     *  is reused after its thread exits, the sinks release the shard of the thread
+     *  then, so the shards are bounded by the number of running threads.
+     */
+    struct ThreadRegistry
+    {
+        std::mutex mutex;
+        unsigned int thread_count = 0;
+        std::set<unsigned int> free_numbers;
+        std::map<uint64_t, Impl*> sharded_sinks;    // by sink id
+    };
+
+    /**
+     * @brief Number of the calling thread, it's released when the thread exits.
+     * 
+     */
+    struct ThreadNumber
+    {
+        unsigned int number;
+
+        ThreadNumber();
+        ~ThreadNumber();
+    };
+
+    // the shards post their background tasks to the worker of the sink
+    std::shared_ptr<BackgroundWorker> worker;
 
     Impl(const std::string& file_template, unsigned int max_files);
+    ~Impl();
+    static ThreadRegistry& thread_registry();
+    static unsigned int current_thread_number();
+    Impl& current_shard();
+    Impl* find_shard();
+    std::unique_ptr<Impl> take_shard(unsigned int number);
+    template<class F> void for_each_shard(F fn);
     void write_record(ILogRecordData *record, IFormatter *formatter);
-    void remove_old_files(const std::filesystem::path &dir);
+    bool write_pending_record(PendingRecord &record);
+    void combine();
+    void open_file(const std::tm &datetime, unsigned int start_index = 0);
+    void open_next_file(const std::tm &datetime);
+    std::string lock_filename(const std::string &filename) const;
+    void prepare_next_file(const std::tm &datetime);
+    PreparedFile take_prepared_file(const std::string &filename);
+    void schedule_period_file();
+    void prepare_period_file(int64_t period_ms, FileWriter writer, Compression stream,
+        uint64_t max_size, uint64_t preallocate);
+    PreparedFile take_period_file();
+    void discard_prepared_file();
+    void close_prepared_file(PreparedFile &prepared);
+    void set_active_file(const std::string &filename);
+    void file_rotated(const std::string &closed_filename, uint64_t closed_size);
+    void set_flush_policy(const FlushPolicy &policy);
+    void start_flush_timer();
+    size_t flush_buffer_size() const;
+    uint64_t closing_file_size();
+    void flush();
+    void set_sync_policy(const SyncPolicy &policy);
+    bool sync_enabled() const;
+    bool sync_file(LogFile *log_file);
+    bool commit(uint64_t seq, bool waited);
+    bool sync();
+    void sync_closing_file();
 
+    /**
+     * @brief Converts the record time to the local datetime only if the format has the time.
+     * 
+     */
     struct TimeFormatter : public ITimeFormatter
     {
+        int64_t time;
         std::tm datetime;
+        bool converted = false;
+
         TimeFormatter(ILogRecordData *record)
-        {
-            local_datetime(&datetime, static_cast<time_t>(record->get_time()/1000));
-        }
+            : time{record->get_time()}
+        { }
 
         virtual void format_time(char *res, size_t maxsize, const char *fmt) override
         {
+            if (!converted) {
+                local_datetime(&datetime, static_cast<time_t>(time/1000));
+                converted = true;
+            }
             std::strftime(res, maxsize, fmt, &datetime);
         }
     };
@@ -47,73 +246,1037 @@ public:
 
 FileSink::Impl::Impl(const std::string& file_template, unsigned int max_files)
     : filename_template{file_template}
+    , lock_name{"." + std::filesystem::path{file_template}.filename().string() + ".lock"}
     , max_num_files{max_files}
+    , file_writer{FileWriter::STREAM}
+    , max_file_size{0}
+    , max_total_size{0}
+    , file_size{0}
+    , file_index{0}
+    , retention{filename_template}
+    , compression{Compression::NONE}
+    , stream_compression{Compression::NONE}
+    , frame_size{default_frame_size}
+    , frame_interval_ms{default_frame_interval_ms}
+    , shared_mode{false}
+    , compressor{FileCompressor::instance()}
+    , unsynced_records{0}
+    , written_seq{0}
+    , synced_seq{0}
+    , failed_seq{0}
+    , syncing{false}
+    , prepare_ahead_ms{default_prepare_ahead_ms}
+    , preallocate_size{0}
+    , pending_records{nullptr}
+    , combining{false}
+    , combine_generation{0}
+    , sharded{filename_template.has_thread()}
+    , sink_id{0}
+    , worker{std::make_shared<BackgroundWorker>()}
+{
+    static std::atomic<uint64_t> sink_count{0};
+    memset(&file_tm, 0, sizeof(file_tm));
+    retention.set_limits(max_num_files, max_total_size);
+    if (sharded) {
+        sink_id = ++sink_count;
+        auto &registry = thread_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.sharded_sinks[sink_id] = this;
+    }
+}
+
+FileSink::Impl::~Impl()
+{
+    if (sharded) {
+        auto &registry = thread_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.sharded_sinks.erase(sink_id);
+    }
+    // the shards use the worker, they're destroyed first
+    shards.clear();
+
+    flush_timer.stop();
+    sync_timer.stop();
+    prepare_timer.stop();
+    compressor->cancel(this);
+    worker->wait();
+    discard_prepared_file();
+}
+
+/**
+ * @brief Returns the registry of the thread numbers. It's never destroyed,
+ *  threads can exit after the static objects are destroyed.
+ * 
+ * @return ThreadRegistry& 
+ */
+FileSink::Impl::ThreadRegistry& FileSink::Impl::thread_registry()
+{
+    static ThreadRegistry *registry = new ThreadRegistry();
+    return *registry;
+}
+
+FileSink::Impl::ThreadNumber::ThreadNumber()
+{
+    auto &registry = thread_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (registry.free_numbers.empty()) {
+        number = ++registry.thread_count;
+    } else {
+        number = *registry.free_numbers.begin();
+        registry.free_numbers.erase(registry.free_numbers.begin());
+    }
+}
+
+/**
+ * @brief Closes the files of the exiting thread. The shards are taken from the sinks
+ *  in the registry lock and destroyed after it, closing a file doesn't block other threads.
+ *  The number is freed after that, so a new thread doesn't reopen the files before they're closed.
+ * 
+ */
+FileSink::Impl::ThreadNumber::~ThreadNumber()
+{
+    auto &registry = thread_registry();
+    std::vector<std::unique_ptr<Impl>> shards;
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (auto &sink : registry.sharded_sinks) {
+            if (auto shard = sink.second->take_shard(number)) {
+                shards.push_back(std::move(shard));
+            }
+        }
+    }
+    // the shards own references to the worker and the compressor, they outlive the sink
+    shards.clear();
+
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.free_numbers.insert(number);
+}
+
+/**
+ * @brief Returns the number of the calling thread used for %t, threads are numbered from 1.
+ *  Numbers of exited threads are reused, the lowest free one is taken.
+ * 
+ * @return unsigned int 
+ */
+unsigned int FileSink::Impl::current_thread_number()
+{
+    thread_local ThreadNumber thread_number;
+    return thread_number.number;
+}
+
+/**
+ * @brief Removes the shard of the exited thread, its number is reused by a new thread
+ *  that continues the files with a new shard.
+ * 
+ * @param number 
+ * @return std::unique_ptr<Impl> the shard to destroy or nullptr if the thread has no shard
+ */
+std::unique_ptr<FileSink::Impl> FileSink::Impl::take_shard(unsigned int number)
+{
+    std::unique_ptr<Impl> shard;
+    {
+        std::lock_guard<std::mutex> lock(shards_mutex);
+        auto it = shards.find(number);
+        if (it == shards.end()) {
+            return nullptr;
+        }
+        shard = std::move(it->second);
+        shards.erase(it);
+    }
+    {
+        // the statistics of the released shard are kept
+        std::lock_guard<std::mutex> shard_lock(shard->sync_mutex);
+        std::lock_guard<std::mutex> lock(sync_mutex);
+        sync_stats.commits += shard->sync_stats.commits;
+        sync_stats.syncs += shard->sync_stats.syncs;
+        sync_stats.failures += shard->sync_stats.failures;
+        sync_stats.total_commit_us += shard->sync_stats.total_commit_us;
+        sync_stats.max_commit_us = std::max(sync_stats.max_commit_us, shard->sync_stats.max_commit_us);
+    }
+    return shard;
+}
+
+/**
+ * @brief Returns the sink of the calling thread's files, creates it with the current settings.
+ * 
+ * @return Impl& 
+ */
+FileSink::Impl& FileSink::Impl::current_shard()
+{
+    if (!sharded) {
+        return *this;
+    }
+
+    struct CachedShard
+    {
+        uint64_t sink_id;
+        Impl *shard;
+    };
+    // sink ids aren't reused, so entries of destroyed sinks are never matched
+    thread_local std::vector<CachedShard> cached_shards;
+    for (auto &cached : cached_shards) {
+        if (cached.sink_id == sink_id) {
+            return *cached.shard;
+        }
+    }
+
+    // the number is taken before the lock, an exiting thread locks the shards in the registry lock
+    unsigned int number = current_thread_number();
+    {
+        // a miss drops the entries of destroyed sinks, the cache is bounded by the live sinks
+        auto &registry = thread_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        cached_shards.erase(
+            std::remove_if(cached_shards.begin(), cached_shards.end(), [&registry](const CachedShard &cached) {
+                return !registry.sharded_sinks.count(cached.sink_id);
+            }),
+            cached_shards.end());
+    }
+    std::lock_guard<std::mutex> lock(shards_mutex);
+    auto &shard = shards[number];
+    if (!shard) {
+        shard = std::make_unique<Impl>(filename_template.bind_thread(number), max_num_files);
+        shard->worker = worker;
+        std::lock_guard<std::mutex> file_lock(file_mutex);
+        shard->file_writer = file_writer;
+        shard->shared_mode = shared_mode;
+        shard->max_file_size = max_file_size;
+        shard->max_total_size = max_total_size;
+        shard->retention.set_limits(max_num_files, max_total_size);
+        shard->compression = compression;
+        shard->stream_compression = stream_compression;
+        shard->frame_size = frame_size;
+        shard->frame_interval_ms = frame_interval_ms;
+        shard->prepare_ahead_ms = prepare_ahead_ms;
+        shard->preallocate_size = preallocate_size;
+        shard->set_flush_policy(flush_policy);
+        shard->set_sync_policy(sync_policy);
+    }
+    cached_shards.push_back({sink_id, shard.get()});
+    return *shard;
+}
+
+/**
+ * @brief Returns the sink of the calling thread's files if it's created.
+ * 
+ * @return Impl* 
+ */
+FileSink::Impl* FileSink::Impl::find_shard()
+{
+    if (!sharded) {
+        return this;
+    }
+    unsigned int number = current_thread_number();
+    std::lock_guard<std::mutex> lock(shards_mutex);
+    auto it = shards.find(number);
+    return it != shards.end() ? it->second.get() : nullptr;
+}
+
+/**
+ * @brief Applies the function to this object and the sinks of all threads.
+ * 
+ * @param fn 
+ */
+template<class F>
+void FileSink::Impl::for_each_shard(F fn)
 {
-    memset(&last_record_tm, 0, sizeof(last_record_tm));
+    std::lock_guard<std::mutex> lock(shards_mutex);
+    fn(*this);
+    for (auto &shard : shards) {
+        fn(*shard.second);
+    }
+}
+
+void FileSink::Impl::set_flush_policy(const FlushPolicy &policy)
+{
+    flush_timer.stop();
+    {
+        std::lock_guard<std::mutex> lock(file_mutex);
+        flush_policy = policy;
+        if (file && file->buffered_size() >= flush_buffer_size()) {
+            file->flush();
+        }
+    }
+    start_flush_timer();
+}
+
+/**
+ * @brief Starts the flush timer with the interval of the flush policy,
+ *  or of the frames when the stream compression is set.
+ * 
+ */
+void FileSink::Impl::start_flush_timer()
+{
+    flush_timer.stop();
+    unsigned int interval_ms = stream_compression != Compression::NONE
+        ? frame_interval_ms
+        : flush_policy.interval_ms;
+    if (interval_ms) {
+        flush_timer.start(interval_ms, [this]() { flush(); });
+    }
+}
+
+/**
+ * @brief Returns the size of the buffered records that are flushed, every flush
+ *  of a compressed file writes a frame, so it's the frame size then.
+ * 
+ * @return size_t 
+ */
+size_t FileSink::Impl::flush_buffer_size() const
+{
+    return stream_compression != Compression::NONE ? frame_size : flush_policy.buffer_size;
+}
+
+/**
+ * @brief Returns the final size of the file being closed. A compressed file
+ *  is measured on disk, so its last frame is written first.
+ * 
+ * @return uint64_t 
+ */
+uint64_t FileSink::Impl::closing_file_size()
+{
+    if (!file) {
+        return 0;
+    }
+    if (stream_compression != Compression::NONE) {
+        file->flush();
+        file_size = file->disk_size();
+    }
+    return file_size;
+}
+
+void FileSink::Impl::flush()
+{
+    std::lock_guard<std::mutex> lock(file_mutex);
+    if (file) {
+        file->flush();
+    }
+}
+
+void FileSink::Impl::set_sync_policy(const SyncPolicy &policy)
+{
+    sync_timer.stop();
+    {
+        std::lock_guard<std::mutex> lock(file_mutex);
+        sync_policy = policy;
+        unsynced_records = 0;
+    }
+    if (sync_policy.interval_ms) {
+        sync_timer.start(sync_policy.interval_ms, [this]() {
+            uint64_t seq;
+            {
+                std::lock_guard<std::mutex> lock(file_mutex);
+                seq = written_seq;
+            }
+            commit(seq, false);
+        });
+    }
+}
+
+bool FileSink::Impl::sync_enabled() const
+{
+    return sync_policy.records || sync_policy.interval_ms || sync_policy.sync_level != LogLevel::DISABLED;
+}
+
+/**
+ * @brief Syncs the written data of the file to the storage device.
+ * 
+ * @param log_file 
+ * @return true if the data is synced
+ */
+bool FileSink::Impl::sync_file(LogFile *log_file)
+{
+#ifdef __unix__
+    int fd = log_file->open_sync_handle();
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = sync_data(fd);
+    ::close(fd);
+    if (!synced) {
+        std::cerr 
+            << "Can't sync log file: "
+            << log_file->get_filename()
+            << std::endl;
+    }
+    return synced;
+#else
+    log_file->flush();
+    return false;
+#endif
+}
+
+/**
+ * @brief Waits until the records up to seq are synced (group commit).
+ *  The first waiting thread syncs the file for all the records written
+ *  by that moment, the others wait for its result.
+ * 
+ * @param seq       sequence number of the last record to sync
+ * @param waited    the commit is counted in the stats
+ * @return false if the sync of the records failed
+ */
+bool FileSink::Impl::commit(uint64_t seq, bool waited)
+{
+    auto start = std::chrono::steady_clock::now();
+    bool result = true;
+
+    std::unique_lock<std::mutex> lock(sync_mutex);
+    uint64_t failures = sync_stats.failures;
+    while (synced_seq < seq) {
+        if (sync_stats.failures != failures && failed_seq >= seq) {
+            // a sync that covered the records has failed since the commit started
+            result = false;
+            break;
+        }
+        if (syncing) {
+            sync_cv.wait(lock);
+            continue;
+        }
+        syncing = true;
+        lock.unlock();
+
+        uint64_t target;
+        int fd = -1;
+        bool synced = false;
+        {
+            std::lock_guard<std::mutex> file_lock(file_mutex);
+            target = written_seq;
+#ifdef __unix__
+            fd = file ? file->open_sync_handle() : -1;
+#endif
+        }
+        // the file isn't locked during the sync, writers go on with the next group
+#ifdef __unix__
+        if (fd >= 0) {
+            synced = sync_data(fd);
+            if (!synced) {
+                std::cerr 
+                    << "Can't sync log file"
+                    << std::endl;
+            }
+            ::close(fd);
+        }
+#endif
+
+        lock.lock();
+        syncing = false;
+        if (synced) {
+            synced_seq = std::max(synced_seq, target);
+            ++sync_stats.syncs;
+        } else {
+            failed_seq = std::max(failed_seq, target);
+            ++sync_stats.failures;
+        }
+        sync_cv.notify_all();
+    }
+
+    if (waited) {
+        auto latency = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        ++sync_stats.commits;
+        sync_stats.total_commit_us += latency;
+        sync_stats.max_commit_us = std::max(sync_stats.max_commit_us, latency);
+    }
+    return result;
+}
+
+bool FileSink::Impl::sync()
+{
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(file_mutex);
+        seq = written_seq;
+    }
+    return commit(seq, true);
 }
 
+/**
+ * @brief Formats the record and writes it with flat combining: the record is published
+ *  to the pending list, and the thread that takes the file lock writes the records of all
+ *  waiting threads in a single batch, while the others wait for their records to be written.
+ * 
+ * @param record 
+ * @param formatter 
+ */
 void FileSink::Impl::write_record(ILogRecordData *record, IFormatter *formatter)
 {
-    FileRecordData data;
+    PendingRecord pending;
     TimeFormatter tf{record};
     
     if (formatter) {
-        formatter->format_record(&data, record, &tf);
+        formatter->format_record(&pending.data, record, &tf);
     } else {
-        data.data = record->get_data();
+        pending.data.append_reference(record->get_data(), static_cast<size_t>(record->get_data_length(false)));
+    }
+    pending.time = tf.time;
+    pending.level = record->get_level();
+
+    pending.next = pending_records.load(std::memory_order_relaxed);
+    while (!pending_records.compare_exchange_weak(pending.next, &pending,
+        std::memory_order_release, std::memory_order_relaxed))
+    { }
+
+    while (true) {
+        if (!file_mutex.try_lock()) {
+            std::unique_lock<std::mutex> lock(combine_mutex);
+            if (pending.done) {
+                break;
+            }
+            if (combining) {
+                // the combiner writes the record or ends its batch
+                uint64_t generation = combine_generation;
+                combine_cv.wait(lock, [&]() { return pending.done || combine_generation != generation; });
+                if (pending.done) {
+                    break;
+                }
+                continue;
+            }
+            // the file is locked by flush or settings
+            lock.unlock();
+            file_mutex.lock();
+        }
+        combine();
+        file_mutex.unlock();
+        combine_cv.notify_all();
+        // the record was published before the lock was taken, so it's written
+        break;
     }
 
-    if (!file || filename_template.is_need_rotate(tf.datetime, last_record_tm)) {
-        auto filename = filename_template.generate_filename(tf.datetime);
+    if (pending.error) {
+        std::rethrow_exception(pending.error);
+    }
+    if (pending.seq) {
+        commit(pending.seq, true);
+    }
+}
+
+/**
+ * @brief Writes the pending records of all threads, it's called with the file locked.
+ * 
+ */
+void FileSink::Impl::combine()
+{
+    {
+        std::lock_guard<std::mutex> lock(combine_mutex);
+        combining = true;
+    }
+
+    PendingRecord *completed = nullptr;
+    bool need_flush = false;
+    size_t count = 0;
+    while (count < max_combined_records) {
+        PendingRecord *records = pending_records.exchange(nullptr, std::memory_order_acquire);
+        if (!records) {
+            break;
+        }
+        // the list is LIFO, restore the order of the records
+        PendingRecord *ordered = nullptr;
+        while (records) {
+            PendingRecord *next = records->next;
+            records->next = ordered;
+            ordered = records;
+            records = next;
+        }
+        while (ordered) {
+            PendingRecord *next = ordered->next;
+            try {
+                need_flush = write_pending_record(*ordered) || need_flush;
+            } catch (...) {
+                ordered->error = std::current_exception();
+            }
+            ordered->next = completed;
+            completed = ordered;
+            ordered = next;
+            ++count;
+        }
+    }
+
+    if (file && (need_flush || file->buffered_size() >= flush_buffer_size())) {
+        file->flush();
+    }
+
+    std::lock_guard<std::mutex> lock(combine_mutex);
+    while (completed) {
+        // the record is owned by its thread once it's done
+        PendingRecord *next = completed->next;
+        completed->done = true;
+        completed = next;
+    }
+    combining = false;
+    ++combine_generation;
+}
+
+/**
+ * @brief Writes the record to the file, rotates the file if needed.
+ * 
+ * @param record 
+ * @return true if the record requires the flush
+ */
+bool FileSink::Impl::write_pending_record(PendingRecord &record)
+{
+    bool compressed = stream_compression != Compression::NONE;
+    uint64_t record_size = record.data.length() + 1;
+    if (file && shared_mode && max_file_size) {
+        // other processes append to the file too
+        file_size = file->disk_size() + file->buffered_size();
+    } else if (file && compressed) {
+        // the size of a compressed file is known on disk only, records count when their frame is written
+        file_size = file->disk_size();
+        record_size = 0;
+    }
+
+    // a late record of another thread goes to the current file, the rotation only moves forward
+    if (!file || record.time >= rotation_period.end_ms) {
+        std::tm datetime;
+        local_datetime(&datetime, static_cast<time_t>(record.time/1000));
+        open_file(datetime);
+    } else if (max_file_size && file_size
+        && (compressed ? file_size >= max_file_size : file_size + record_size > max_file_size))
+    {
+        open_next_file(file_tm);
+    }
+
+    file_size += record_size;
+    if (!record.data.references.empty() && !file->writes_references()) {
+        record.data.resolve_references();
+    }
+    file->write(record.data);
+    ++written_seq;
+    if ((sync_policy.records && ++unsynced_records >= sync_policy.records)
+        || (sync_policy.sync_level != LogLevel::DISABLED && record.level >= sync_policy.sync_level))
+    {
+        unsynced_records = 0;
+        record.seq = written_seq;
+    }
+
+    return record.level >= flush_policy.flush_level;
+}
+
+/**
+ * @brief Syncs the file closed by rotation, so the records written
+ *  to it are durable before the writing goes on to the next file.
+ * 
+ */
+void FileSink::Impl::sync_closing_file()
+{
+    if (!file || !sync_enabled()) {
+        return;
+    }
+    bool synced = sync_file(file.get());
+    std::lock_guard<std::mutex> lock(sync_mutex);
+    if (synced) {
+        synced_seq = std::max(synced_seq, written_seq);
+        ++sync_stats.syncs;
+    } else {
+        // the waiters of the closed file's records get the failure
+        failed_seq = std::max(failed_seq, written_seq);
+        ++sync_stats.failures;
+    }
+    sync_cv.notify_all();
+}
+
+/**
+ * @brief Checks if the file was already rotated and compressed.
+ * 
+ * @param filename 
+ * @return true 
+ * @return false 
+ */
+static bool compressed_file_exists(const std::string &filename)
+{
+    std::error_code code;
+    return std::filesystem::exists(filename + compression_suffix(Compression::GZIP), code)
+        || std::filesystem::exists(filename + compression_suffix(Compression::ZSTD), code);
+}
+
+/**
+ * @brief Opens the file for the datetime, skips the files that reached the size limit.
+ *  In the shared mode the choice of the file is serialized with other processes by the lock file.
+ * 
+ * @param datetime 
+ * @param start_index   index of the first file to check
+ */
+void FileSink::Impl::open_file(const std::tm &datetime, unsigned int start_index)
+{
+    sync_closing_file();
+
+    std::string closed_filename = file ? file->get_filename() : "";
+    uint64_t closed_size = closing_file_size();
+    file.reset();
+
+    file_tm = datetime;
+    rotation_period = filename_template.get_rotation_period(datetime);
+
+    // the writer doesn't wait for the background thread, the file is opened directly if it isn't ready
+    PreparedFile prepared = take_period_file();
+    worker->post([this]() { discard_prepared_file(); });
+
+    if (prepared.file) {
+        set_active_file(prepared.filename);
+        file = std::move(prepared.file);
+        file_size = prepared.size;
+        file_index = prepared.index;
+        file_rotated(closed_filename, closed_size);
+        if (max_file_size) {
+            prepare_next_file(datetime);
+        }
+        schedule_period_file();
+        return;
+    }
+
+    file_index = start_index;
+    std::string filename = filename_template.generate_filename(datetime, file_index);
+    std::filesystem::path dir{filename};
+    dir.remove_filename();
+    if (!dir.empty()) {
+        std::filesystem::create_directories(dir);
+    }
+
+#ifdef __unix__
+    std::unique_ptr<FileLock> lock;
+    if (shared_mode) {
+        lock = std::make_unique<FileLock>(lock_filename(filename));
+    }
+#endif
+
+    std::error_code code;
+    file_size = 0;
+    while (true) {
+        auto size = std::filesystem::file_size(filename, code);
+        file_size = code ? 0 : size;
+        if (!max_file_size || (file_size < max_file_size && !compressed_file_exists(filename))) {
+            break;
+        }
+        filename = filename_template.generate_filename(datetime, ++file_index);
+    }
+
+    bool created = !std::filesystem::exists(filename, code);
+    set_active_file(filename);
+    file = shared_mode
+        ? make_log_file(FileWriter::FD, filename, Compression::NONE, shared_write_size)
+        : make_log_file(file_writer, filename, stream_compression);
+
+#ifdef __unix__
+    lock.reset();
+#endif
+
+    if (shared_mode) {
+        // only the process that created the file applies the retention
+        if (created) {
+            file_rotated(closed_filename, closed_size);
+        }
+        return;
+    }
+
+    file_rotated(closed_filename, closed_size);
+
+    if (max_file_size) {
+        prepare_next_file(datetime);
+    }
+    schedule_period_file();
+}
+
+/**
+ * @brief Switches to the file with the next index, takes the file opened ahead of time if it's ready.
+ * 
+ * @param datetime 
+ */
+void FileSink::Impl::open_next_file(const std::tm &datetime)
+{
+    if (shared_mode) {
+        open_file(datetime, file_index + 1);
+        return;
+    }
+
+    sync_closing_file();
+
+    std::string closed_filename = file->get_filename();
+    uint64_t closed_size = closing_file_size();
+
+    std::string filename = filename_template.generate_filename(datetime, ++file_index);
+    // the file is opened directly if the writer is ahead of the background thread
+    PreparedFile prepared = take_prepared_file(filename);
+    set_active_file(filename);
+    if (prepared.file) {
+        file = std::move(prepared.file);
+        file_size = prepared.size;
+    } else {
         std::filesystem::path dir{filename};
         dir.remove_filename();
-        std::filesystem::create_directories(dir);
-        file = std::make_unique<LogFile>(filename);
-        remove_old_files(dir);
+        if (!dir.empty()) {
+            std::filesystem::create_directories(dir);
+        }
+        std::error_code code;
+        auto size = std::filesystem::file_size(filename, code);
+        file_size = code ? 0 : size;
+        file = make_log_file(file_writer, filename, stream_compression);
     }
 
-    file->write(data);
-    
-    last_record_tm = tf.datetime;
+    file_rotated(closed_filename, closed_size);
+
+    prepare_next_file(datetime);
+}
+
+/**
+ * @brief Returns the lock file of the shared mode, it's placed next to the log file.
+ * 
+ * @param filename 
+ * @return std::string 
+ */
+std::string FileSink::Impl::lock_filename(const std::string &filename) const
+{
+    return (std::filesystem::path{filename}.parent_path() / lock_name).string();
+}
+
+/**
+ * @brief Opens the file with the next index in the background.
+ * 
+ * @param datetime 
+ */
+void FileSink::Impl::prepare_next_file(const std::tm &datetime)
+{
+    std::string filename = filename_template.generate_filename(datetime, file_index + 1);
+    FileWriter writer = file_writer;
+    Compression stream = stream_compression;
+
+    worker->post([this, filename, writer, stream]() {
+        PreparedFile prepared;
+        std::error_code code;
+        std::filesystem::path dir{filename};
+        dir.remove_filename();
+        std::filesystem::create_directories(dir, code);
+        prepared.filename = filename;
+        prepared.created = !std::filesystem::exists(filename, code);
+        prepared.file = make_log_file(writer, filename, stream);
+        auto size = std::filesystem::file_size(filename, code);
+        prepared.size = code ? 0 : size;
+
+        {
+            std::lock_guard<std::mutex> lock(next_file_mutex);
+            std::swap(next_file, prepared);
+        }
+        close_prepared_file(prepared);
+    });
+}
+
+/**
+ * @brief Takes the file opened ahead of time if it has the given name.
+ * 
+ * @param filename 
+ * @return PreparedFile 
+ */
+FileSink::Impl::PreparedFile FileSink::Impl::take_prepared_file(const std::string &filename)
+{
+    PreparedFile prepared;
+    std::lock_guard<std::mutex> lock(next_file_mutex);
+    if (next_file.file && next_file.filename == filename) {
+        prepared = std::move(next_file);
+        next_file = PreparedFile{};
+    }
+    return prepared;
 }
 
-void FileSink::Impl::remove_old_files(const std::filesystem::path &dir)
+/**
+ * @brief Schedules opening of the file of the next time period, it's opened in the background
+ *  shortly before the end of the current period. Files of past periods aren't prepared.
+ * 
+ */
+void FileSink::Impl::schedule_period_file()
 {
-    if (!max_num_files || !filename_template.rotatable()) {
+    prepare_timer.cancel();
+    if (!prepare_ahead_ms || shared_mode || rotation_period.end_ms == std::numeric_limits<int64_t>::max()) {
         return;
     }
 
-    std::filesystem::path oldest_file_path;
-    TemplateFileParams oldest_file_params;
-    oldest_file_params.year = std::numeric_limits<decltype(oldest_file_params.year)>::max();
-    size_t count = 0;
-    
-    for (auto& p: std::filesystem::directory_iterator(dir)) {
-        if (p.is_regular_file()) {
-            auto name = convert_str<std::string>(p.path().filename().u8string());
-            auto params = filename_template.parse_filename(name);
-            if (params.has_value()) {
-                if (params.value() < oldest_file_params) {
-                    oldest_file_params = params.value();
-                    oldest_file_path = p.path();
-                }
-                ++count;
-            }
+    using namespace std::chrono;
+    int64_t period_ms = rotation_period.end_ms;
+    int64_t now_ms = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+    if (period_ms <= now_ms) {
+        return;
+    }
+
+    FileWriter writer = file_writer;
+    Compression stream = stream_compression;
+    uint64_t max_size = max_file_size;
+    uint64_t preallocate = preallocate_size;
+    auto time = system_clock::time_point{milliseconds{period_ms - prepare_ahead_ms}};
+    prepare_timer.schedule(time, [this, period_ms, writer, stream, max_size, preallocate]() {
+        worker->post([this, period_ms, writer, stream, max_size, preallocate]() {
+            prepare_period_file(period_ms, writer, stream, max_size, preallocate);
+        });
+    });
+}
+
+/**
+ * @brief Opens the file of the time period starting at period_ms, skips the files
+ *  that reached the size limit. It's called in the background thread.
+ * 
+ * @param period_ms     start of the period in milliseconds since epoch
+ * @param writer 
+ * @param stream        compression of the records
+ * @param max_size      maximum file size, 0 - unlimited
+ * @param preallocate   size of the disk space allocated for a new file, 0 - none
+ */
+void FileSink::Impl::prepare_period_file(int64_t period_ms, FileWriter writer, Compression stream,
+    uint64_t max_size, uint64_t preallocate)
+{
+    std::tm datetime;
+    local_datetime(&datetime, static_cast<time_t>(period_ms/1000));
+
+    PreparedFile prepared;
+    prepared.period_start = filename_template.get_rotation_period(datetime).start_ms;
+    prepared.writer = writer;
+    prepared.stream = stream;
+
+    std::string filename = filename_template.generate_filename(datetime, 0);
+    std::error_code code;
+    std::filesystem::path dir{filename};
+    dir.remove_filename();
+    if (!dir.empty()) {
+        std::filesystem::create_directories(dir, code);
+    }
+
+    while (true) {
+        auto size = std::filesystem::file_size(filename, code);
+        prepared.size = code ? 0 : size;
+        if (!max_size || (prepared.size < max_size && !compressed_file_exists(filename))) {
+            break;
         }
+        filename = filename_template.generate_filename(datetime, ++prepared.index);
+    }
+
+    prepared.filename = filename;
+    prepared.created = !std::filesystem::exists(filename, code);
+    prepared.file = make_log_file(writer, filename, stream);
+    if (preallocate && prepared.created) {
+        preallocate_file(filename, preallocate);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(next_file_mutex);
+        std::swap(period_file, prepared);
+    }
+    close_prepared_file(prepared);
+}
+
+/**
+ * @brief Takes the file opened ahead of time for the current time period
+ *  if it was opened with the current settings.
+ * 
+ * @return PreparedFile 
+ */
+FileSink::Impl::PreparedFile FileSink::Impl::take_period_file()
+{
+    PreparedFile prepared;
+    if (shared_mode) {
+        return prepared;
+    }
+    std::lock_guard<std::mutex> lock(next_file_mutex);
+    if (period_file.file && period_file.period_start == rotation_period.start_ms
+        && period_file.writer == file_writer && period_file.stream == stream_compression
+        && (!max_file_size || period_file.size < max_file_size))
+    {
+        prepared = std::move(period_file);
+        period_file = PreparedFile{};
+    }
+    return prepared;
+}
+
+/**
+ * @brief Closes the files opened ahead of time, removes them if they were created empty.
+ * 
+ */
+void FileSink::Impl::discard_prepared_file()
+{
+    PreparedFile prepared[2];
+    {
+        std::lock_guard<std::mutex> lock(next_file_mutex);
+        prepared[0] = std::move(next_file);
+        prepared[1] = std::move(period_file);
+        next_file = PreparedFile{};
+        period_file = PreparedFile{};
+    }
+
+    for (auto &file : prepared) {
+        close_prepared_file(file);
     }
+}
 
-    if (count > max_num_files) {
+/**
+ * @brief Closes the file opened ahead of time, removes it if it was created empty
+ *  and the writer hasn't opened it directly.
+ * 
+ * @param prepared 
+ */
+void FileSink::Impl::close_prepared_file(PreparedFile &prepared)
+{
+    if (prepared.file) {
+        prepared.file.reset();
         std::error_code code;
-        if (!std::filesystem::remove(oldest_file_path, code)) {
-            std::cerr 
-                << "Can't remove old log file: " 
-                << oldest_file_path 
-                << ", code: " << code
-                << std::endl;
+        std::lock_guard<std::mutex> lock(next_file_mutex);
+        if (prepared.created && prepared.filename != active_filename
+            && std::filesystem::file_size(prepared.filename, code) == 0 && !code)
+        {
+            std::filesystem::remove(prepared.filename, code);
         }
     }
 }
 
+/**
+ * @brief Marks the file used by the writer, it's set before the file is opened,
+ *  so a prepared file of the same name isn't removed under the writer.
+ * 
+ * @param filename 
+ */
+void FileSink::Impl::set_active_file(const std::string &filename)
+{
+    std::lock_guard<std::mutex> lock(next_file_mutex);
+    active_filename = filename;
+}
+
+/**
+ * @brief Updates the retention index and compresses the previous file in the background.
+ * 
+ * @param closed_filename   the previous file, empty if there isn't one
+ * @param closed_size       final size of the previous file
+ */
+void FileSink::Impl::file_rotated(const std::string &closed_filename, uint64_t closed_size)
+{
+    if (max_num_files || max_total_size) {
+        std::string filename = file->get_filename();
+        uint64_t size = file_size;
+        bool shared = shared_mode;
+        worker->post([this, filename, size, closed_filename, closed_size, shared]() {
+#ifdef __unix__
+            std::unique_ptr<FileLock> lock;
+            if (shared) {
+                // other processes create files too, the index is built from the directory
+                lock = std::make_unique<FileLock>(lock_filename(filename));
+                retention.invalidate();
+            }
+#endif
+            if (!closed_filename.empty()) {
+                retention.file_closed(closed_filename, closed_size);
+            }
+            retention.file_opened(filename, size);
+        });
+    }
+
+    // the file that is opened again isn't compressed, the sink goes on writing it
+    if (compression != Compression::NONE && stream_compression == Compression::NONE
+        && !shared_mode && !closed_filename.empty() && closed_size
+        && closed_filename != file->get_filename())
+    {
+        compressor->compress(this, closed_filename, compression,
+            [this, closed_filename](const std::string &compressed_filename, uint64_t size) {
+                worker->post([this, closed_filename, compressed_filename, size]() {
+                    retention.file_compressed(closed_filename, compressed_filename, size);
+                });
+            }
+        );
+    }
+}
+
 /*
  *
  *  FileSink class
@@ -128,12 +1291,180 @@ FileSink::~FileSink() = default;
 
 std::string FileSink::get_filename() const
 {
-    return pimpl->file ? pimpl->file->get_filename() : "";
+    Impl *impl = pimpl->find_shard();
+    if (!impl) {
+        return "";
+    }
+    std::lock_guard<std::mutex> lock(impl->file_mutex);
+    return impl->file ? impl->file->get_filename() : "";
+}
+
+void FileSink::set_flush_policy(const FlushPolicy &policy)
+{
+    pimpl->for_each_shard([&](Impl &impl) {
+        impl.set_flush_policy(policy);
+    });
+}
+
+void FileSink::set_file_writer(FileWriter writer)
+{
+    pimpl->for_each_shard([&](Impl &impl) {
+        std::lock_guard<std::mutex> lock(impl.file_mutex);
+        impl.sync_closing_file();
+        impl.file_writer = writer;
+        impl.file.reset();
+        impl.prepare_timer.cancel();
+        impl.worker->wait();
+        impl.discard_prepared_file();
+    });
+}
+
+bool FileSink::set_shared_mode(bool enable)
+{
+#ifdef __unix__
+    {
+        std::lock_guard<std::mutex> lock(pimpl->file_mutex);
+        if (enable && pimpl->stream_compression != Compression::NONE) {
+            // frames are written through a buffered stream, they'd interleave with other processes
+            return false;
+        }
+    }
+    pimpl->for_each_shard([&](Impl &impl) {
+        std::lock_guard<std::mutex> lock(impl.file_mutex);
+        impl.sync_closing_file();
+        impl.shared_mode = enable;
+        impl.file.reset();
+        impl.prepare_timer.cancel();
+        impl.worker->wait();
+        impl.discard_prepared_file();
+    });
+    return true;
+#else
+    return !enable;
+#endif
+}
+
+void FileSink::set_max_file_size(uint64_t size)
+{
+    if (size && !pimpl->filename_template.has_index()) {
+        throw FileTemplateException("Size rotation requires %i in the file template");
+    }
+    pimpl->for_each_shard([&](Impl &impl) {
+        std::lock_guard<std::mutex> lock(impl.file_mutex);
+        impl.max_file_size = size;
+    });
+}
+
+void FileSink::set_max_total_size(uint64_t size)
+{
+    pimpl->for_each_shard([&](Impl &impl) {
+        std::lock_guard<std::mutex> lock(impl.file_mutex);
+        impl.max_total_size = size;
+        impl.worker->post([impl = &impl, size]() {
+            impl->retention.set_limits(impl->max_num_files, size);
+        });
+    });
+}
+
+void FileSink::set_prepare_ahead(unsigned int lead_ms, uint64_t preallocate_size)
+{
+    pimpl->for_each_shard([&](Impl &impl) {
+        std::lock_guard<std::mutex> lock(impl.file_mutex);
+        impl.prepare_ahead_ms = lead_ms;
+        impl.preallocate_size = preallocate_size;
+        if (impl.file) {
+            impl.schedule_period_file();
+        }
+    });
+}
+
+bool FileSink::set_compression(Compression type)
+{
+    if (!is_compression_supported(type)) {
+        return false;
+    }
+    pimpl->for_each_shard([&](Impl &impl) {
+        std::lock_guard<std::mutex> lock(impl.file_mutex);
+        impl.compression = type;
+    });
+    return true;
+}
+
+bool FileSink::set_stream_compression(Compression type, size_t frame_size, unsigned int frame_interval_ms)
+{
+    if (!is_compression_supported(type)) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pimpl->file_mutex);
+        if (type != Compression::NONE && pimpl->shared_mode) {
+            return false;
+        }
+    }
+    pimpl->for_each_shard([&](Impl &impl) {
+        {
+            std::lock_guard<std::mutex> lock(impl.file_mutex);
+            impl.sync_closing_file();
+            impl.stream_compression = type;
+            impl.frame_size = frame_size;
+            impl.frame_interval_ms = frame_interval_ms;
+            impl.file.reset();
+            impl.prepare_timer.cancel();
+            impl.worker->wait();
+            impl.discard_prepared_file();
+        }
+        impl.start_flush_timer();
+    });
+    return true;
+}
+
+void FileSink::set_sync_policy(const SyncPolicy &policy)
+{
+    pimpl->for_each_shard([&](Impl &impl) {
+        impl.set_sync_policy(policy);
+    });
+}
+
+bool FileSink::sync()
+{
+    bool result = true;
+    pimpl->for_each_shard([&result](Impl &impl) {
+        result = impl.sync() && result;
+    });
+    return result;
+}
+
+SyncStats FileSink::get_sync_stats() const
+{
+    SyncStats stats;
+    pimpl->for_each_shard([&](Impl &impl) {
+        std::lock_guard<std::mutex> lock(impl.sync_mutex);
+        stats.commits += impl.sync_stats.commits;
+        stats.syncs += impl.sync_stats.syncs;
+        stats.failures += impl.sync_stats.failures;
+        stats.total_commit_us += impl.sync_stats.total_commit_us;
+        stats.max_commit_us = std::max(stats.max_commit_us, impl.sync_stats.max_commit_us);
+    });
+    return stats;
+}
+
+void FileSink::set_compression_threads(unsigned int count)
+{
+    FileCompressor::instance()->set_max_threads(count);
+}
+
+void FileSink::flush()
+{
+    pimpl->for_each_shard([](Impl &impl) {
+        impl.flush();
+        impl.compressor->wait(&impl);
+        impl.worker->wait();
+    });
 }
 
 void FileSink::write(ILogRecordData *record, IFormatter *logger_formatter)
 {
-    pimpl->write_record(
+    pimpl->current_shard().write_record(
         record,
         sink_formatter ? static_cast<IFormatter*>(sink_formatter.get()) : logger_formatter
     );
@@ -0,0 +1,424 @@
+#include <logging/sink/filter.h>
+#include <logging/log_level.h>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <cctype>
+
+namespace logging {
+
+const char* FilterException::what() const noexcept
+{
+    return desc.c_str();
+}
+
+/**
+ * @brief Checks if the text contains the pattern. Candidates are found
+ *  by the first character with memchr, which is vectorized by the C library.
+ *
+ * @param text
+ * @param length
+ * @param pattern
+ * @return true
+ * @return false
+ */
+static bool contains(const char *text, size_t length, const std::string &pattern)
+{
+    if (pattern.empty()) {
+        return true;
+    }
+    if (pattern.length() > length) {
+        return false;
+    }
+    const char *end = text + length - pattern.length() + 1;
+    const char first = pattern[0];
+    while (text < end) {
+        text = static_cast<const char*>(memchr(text, first, static_cast<size_t>(end - text)));
+        if (!text) {
+            return false;
+        }
+        if (memcmp(text + 1, pattern.data() + 1, pattern.length() - 1) == 0) {
+            return true;
+        }
+        ++text;
+    }
+    return false;
+}
+
+enum class FilterOpCode : uint8_t
+{
+    LEVEL,
+    LINE,
+    FILE,
+    MESSAGE,
+    NOT,
+    JUMP_IF_FALSE,
+    JUMP_IF_TRUE,
+};
+
+enum class FilterCompare : uint8_t
+{
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+    STARTS_WITH,
+    ENDS_WITH,
+    CONTAINS,
+};
+
+/*
+ *
+ *  FilterSink::Impl class
+ *
+ */
+
+class FilterSink::Impl
+{
+public:
+
+    using OpCode = FilterOpCode;
+    using Compare = FilterCompare;
+
+    /**
+     * @brief Instruction of the filter program. Conditions set the result register,
+     *  jumps implement short-circuit evaluation of and/or.
+     */
+    struct Instruction
+    {
+        OpCode op;
+        Compare compare;
+        int64_t value;      // level, line number, index of the string or the jump target
+    };
+
+    ILogSink *sink;
+    std::vector<Instruction> program;
+    std::vector<std::string> strings;
+
+    Impl(ILogSink *sink, const std::string &expression);
+    bool matches(const ILogRecordData *record) const;
+
+private:
+
+    enum class TokenType
+    {
+        IDENT,
+        STRING,
+        NUMBER,
+        OPERATOR,
+        END,
+    };
+
+    struct Token
+    {
+        TokenType type;
+        std::string text;
+        size_t pos;
+    };
+
+    std::vector<Token> tokens;
+    size_t token_pos;
+
+    void tokenize(const std::string &expression);
+    const Token& peek() const { return tokens[token_pos]; }
+    const Token& next() { return tokens[token_pos++]; }
+    bool accept(const char *text);
+    [[noreturn]] void error(const std::string &message, const Token &token) const;
+    void parse_or();
+    void parse_and();
+    void parse_not();
+    void parse_condition();
+    Compare parse_compare(bool text);
+};
+
+FilterSink::Impl::Impl(ILogSink *sink, const std::string &expression)
+    : sink{sink}
+    , token_pos{0}
+{
+    tokenize(expression);
+    parse_or();
+    if (peek().type != TokenType::END) {
+        error("unexpected token", peek());
+    }
+    tokens.clear();
+}
+
+void FilterSink::Impl::error(const std::string &message, const Token &token) const
+{
+    throw FilterException(message + " at position " + std::to_string(token.pos));
+}
+
+void FilterSink::Impl::tokenize(const std::string &expression)
+{
+    static const char* operators[] = {"==", "!=", "<=", ">=", "&&", "||", "<", ">", "!", "(", ")"};
+
+    size_t pos = 0;
+    while (pos < expression.length()) {
+        char c = expression[pos];
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            ++pos;
+            continue;
+        }
+
+        size_t start = pos;
+        if (isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            while (pos < expression.length()
+                && (isalnum(static_cast<unsigned char>(expression[pos])) || expression[pos] == '_')) {
+                ++pos;
+            }
+            tokens.push_back({TokenType::IDENT, expression.substr(start, pos - start), start});
+        } else if (isdigit(static_cast<unsigned char>(c))) {
+            while (pos < expression.length() && isdigit(static_cast<unsigned char>(expression[pos]))) {
+                ++pos;
+            }
+            tokens.push_back({TokenType::NUMBER, expression.substr(start, pos - start), start});
+        } else if (c == '"') {
+            std::string text;
+            for (++pos; pos < expression.length() && expression[pos] != '"'; ++pos) {
+                if (expression[pos] == '\\' && pos + 1 < expression.length()) {
+                    ++pos;
+                }
+                text += expression[pos];
+            }
+            if (pos >= expression.length()) {
+                throw FilterException("unterminated string at position " + std::to_string(start));
+            }
+            ++pos;
+            tokens.push_back({TokenType::STRING, text, start});
+        } else {
+            const char *op = nullptr;
+            for (auto candidate : operators) {
+                if (expression.compare(pos, strlen(candidate), candidate) == 0) {
+                    op = candidate;
+                    break;
+                }
+            }
+            if (!op) {
+                throw FilterException("unexpected character at position " + std::to_string(start));
+            }
+            pos += strlen(op);
+            tokens.push_back({TokenType::OPERATOR, op, start});
+        }
+    }
+    tokens.push_back({TokenType::END, "", expression.length()});
+}
+
+bool FilterSink::Impl::accept(const char *text)
+{
+    auto &token = peek();
+    if ((token.type == TokenType::OPERATOR || token.type == TokenType::IDENT) && token.text == text) {
+        ++token_pos;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief or-expression: A JUMP_IF_TRUE end B JUMP_IF_TRUE end C end:
+ *
+ */
+void FilterSink::Impl::parse_or()
+{
+    std::vector<size_t> jumps;
+    parse_and();
+    while (accept("or") || accept("||")) {
+        jumps.push_back(program.size());
+        program.push_back({OpCode::JUMP_IF_TRUE, Compare::EQUAL, 0});
+        parse_and();
+    }
+    for (auto jump : jumps) {
+        program[jump].value = static_cast<int64_t>(program.size());
+    }
+}
+
+/**
+ * @brief and-expression: A JUMP_IF_FALSE end B JUMP_IF_FALSE end C end:
+ *
+ */
+void FilterSink::Impl::parse_and()
+{
+    std::vector<size_t> jumps;
+    parse_not();
+    while (accept("and") || accept("&&")) {
+        jumps.push_back(program.size());
+        program.push_back({OpCode::JUMP_IF_FALSE, Compare::EQUAL, 0});
+        parse_not();
+    }
+    for (auto jump : jumps) {
+        program[jump].value = static_cast<int64_t>(program.size());
+    }
+}
+
+void FilterSink::Impl::parse_not()
+{
+    if (accept("not") || accept("!")) {
+        parse_not();
+        program.push_back({OpCode::NOT, Compare::EQUAL, 0});
+    } else if (accept("(")) {
+        parse_or();
+        if (!accept(")")) {
+            error("')' expected", peek());
+        }
+    } else {
+        parse_condition();
+    }
+}
+
+FilterSink::Impl::Compare FilterSink::Impl::parse_compare(bool text)
+{
+    auto &token = next();
+    if (token.type == TokenType::OPERATOR) {
+        if (token.text == "==") return Compare::EQUAL;
+        if (token.text == "!=") return Compare::NOT_EQUAL;
+        if (!text) {
+            if (token.text == "<") return Compare::LESS;
+            if (token.text == "<=") return Compare::LESS_EQUAL;
+            if (token.text == ">") return Compare::GREATER;
+            if (token.text == ">=") return Compare::GREATER_EQUAL;
+        }
+    } else if (token.type == TokenType::IDENT && text) {
+        if (token.text == "starts_with") return Compare::STARTS_WITH;
+        if (token.text == "ends_with") return Compare::ENDS_WITH;
+        if (token.text == "contains") return Compare::CONTAINS;
+    }
+    error("comparison expected", token);
+}
+
+void FilterSink::Impl::parse_condition()
+{
+    auto &field = next();
+    if (field.type != TokenType::IDENT) {
+        error("field name expected", field);
+    }
+
+    if (field.text == "level" || field.text == "line") {
+        bool is_level = field.text == "level";
+        Compare compare = parse_compare(false);
+        auto &value = next();
+        int64_t number;
+        if (value.type == TokenType::NUMBER) {
+            number = std::stoll(value.text);
+        } else if (is_level && value.type == TokenType::IDENT
+            && log_level_by_name(value.text.c_str()) != LogLevel::UNKNOWN) {
+            number = static_cast<int64_t>(log_level_by_name(value.text.c_str()));
+        } else {
+            error(is_level ? "level expected" : "number expected", value);
+        }
+        program.push_back({is_level ? OpCode::LEVEL : OpCode::LINE, compare, number});
+    } else if (field.text == "file" || field.text == "message") {
+        Compare compare = parse_compare(true);
+        auto &value = next();
+        if (value.type != TokenType::STRING) {
+            error("string expected", value);
+        }
+        program.push_back({field.text == "file" ? OpCode::FILE : OpCode::MESSAGE, compare,
+            static_cast<int64_t>(strings.size())});
+        strings.push_back(value.text);
+    } else {
+        error("unknown field '" + field.text + "'", field);
+    }
+}
+
+static bool compare_numbers(int64_t value, FilterCompare compare, int64_t operand)
+{
+    using Compare = FilterCompare;
+    switch (compare) {
+        case Compare::EQUAL:            return value == operand;
+        case Compare::NOT_EQUAL:        return value != operand;
+        case Compare::LESS:             return value < operand;
+        case Compare::LESS_EQUAL:       return value <= operand;
+        case Compare::GREATER:          return value > operand;
+        case Compare::GREATER_EQUAL:    return value >= operand;
+        default:                        return false;
+    }
+}
+
+static bool compare_text(const char *text, size_t length, FilterCompare compare, const std::string &operand)
+{
+    using Compare = FilterCompare;
+    switch (compare) {
+        case Compare::EQUAL:
+            return length == operand.length() && memcmp(text, operand.data(), length) == 0;
+        case Compare::NOT_EQUAL:
+            return length != operand.length() || memcmp(text, operand.data(), length) != 0;
+        case Compare::STARTS_WITH:
+            return length >= operand.length() && memcmp(text, operand.data(), operand.length()) == 0;
+        case Compare::ENDS_WITH:
+            return length >= operand.length()
+                && memcmp(text + length - operand.length(), operand.data(), operand.length()) == 0;
+        case Compare::CONTAINS:
+            return contains(text, length, operand);
+        default:
+            return false;
+    }
+}
+
+bool FilterSink::Impl::matches(const ILogRecordData *record) const
+{
+    bool result = true;
+    size_t pc = 0;
+    while (pc < program.size()) {
+        auto &instruction = program[pc++];
+        switch (instruction.op) {
+            case OpCode::LEVEL:
+                result = compare_numbers(static_cast<int64_t>(record->get_level()),
+                    instruction.compare, instruction.value);
+                break;
+            case OpCode::LINE:
+                result = compare_numbers(record->get_line_number(), instruction.compare, instruction.value);
+                break;
+            case OpCode::FILE:
+            {
+                const char *file = record->get_file_name();
+                result = compare_text(file, strlen(file), instruction.compare, strings[instruction.value]);
+                break;
+            }
+            case OpCode::MESSAGE:
+                result = compare_text(record->get_data(), static_cast<size_t>(record->get_data_length(false)),
+                    instruction.compare, strings[instruction.value]);
+                break;
+            case OpCode::NOT:
+                result = !result;
+                break;
+            case OpCode::JUMP_IF_FALSE:
+                if (!result) {
+                    pc = static_cast<size_t>(instruction.value);
+                }
+                break;
+            case OpCode::JUMP_IF_TRUE:
+                if (result) {
+                    pc = static_cast<size_t>(instruction.value);
+                }
+                break;
+        }
+    }
+    return result;
+}
+
+/*
+ *
+ *  FilterSink class
+ *
+ */
+
+FilterSink::FilterSink(ILogSink *sink, const std::string &expression)
+    : pimpl(std::make_unique<Impl>(sink, expression))
+{ }
+
+FilterSink::~FilterSink() = default;
+
+bool FilterSink::matches(const ILogRecordData *record) const
+{
+    return pimpl->matches(record);
+}
+
+void FilterSink::write(ILogRecordData *record, IFormatter *logger_formatter)
+{
+    if (pimpl->matches(record)) {
+        pimpl->sink->write(record, logger_formatter);
+    }
+}
+
+} // namespace logging
@@ -0,0 +1,63 @@
+#include "background_worker.h"
+
+namespace logging {
+
+BackgroundWorker::~BackgroundWorker()
+{
+    stop();
+}
+
+void BackgroundWorker::post(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+        if (!thread.joinable()) {
+            stopping = false;
+            thread = std::thread(&BackgroundWorker::run, this);
+        }
+    }
+    cv.notify_one();
+}
+
+void BackgroundWorker::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle_cv.wait(lock, [this]() { return tasks.empty() && !busy; });
+}
+
+void BackgroundWorker::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!thread.joinable()) {
+            return;
+        }
+        stopping = true;
+    }
+    cv.notify_one();
+    thread.join();
+}
+
+void BackgroundWorker::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+        if (tasks.empty()) {
+            break;
+        }
+        auto task = std::move(tasks.front());
+        tasks.pop_front();
+        busy = true;
+        lock.unlock();
+        task();
+        lock.lock();
+        busy = false;
+        if (tasks.empty()) {
+            idle_cv.notify_all();
+        }
+    }
+}
+
+} // namespace logging
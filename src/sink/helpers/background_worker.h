@@ -0,0 +1,54 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+namespace logging {
+
+/**
+ * @brief Executes tasks sequentially in a background thread.
+ * 
+ *  The thread is started with the first posted task.
+ */
+class BackgroundWorker
+{
+public:
+
+    BackgroundWorker() = default;
+
+    ~BackgroundWorker();
+
+    BackgroundWorker(const BackgroundWorker&) = delete;
+    BackgroundWorker& operator = (const BackgroundWorker&) = delete;
+
+    void post(std::function<void()> task);
+
+    /**
+     * @brief Waits until all posted tasks are completed.
+     * 
+     */
+    void wait();
+
+    /**
+     * @brief Completes posted tasks and stops the thread.
+     * 
+     */
+    void stop();
+
+private:
+
+    void run();
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::condition_variable idle_cv;
+    std::deque<std::function<void()>> tasks;
+    bool busy = false;
+    bool stopping = false;
+};
+
+} // namespace logging
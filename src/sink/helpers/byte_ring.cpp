@@ -0,0 +1,184 @@
+#include "byte_ring.h"
+#include <new>
+#include <cstring>
+#include <algorithm>
+
+namespace logging {
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring requires lock-free 64-bit atomics");
+
+constexpr uint64_t ring_magic = 0x3230474e4952474cull;   // "LGRING02"
+constexpr uint64_t size_bits = 23;
+constexpr uint64_t size_mask = (1ull << size_bits) - 1;
+constexpr uint64_t commit_flag = 1ull << size_bits;
+constexpr uint64_t tag_shift = size_bits + 1;
+constexpr uint64_t tag_mask = (1ull << (64 - tag_shift)) - 1;
+constexpr uint64_t record_header_words = 4;
+constexpr uint64_t text_offset = record_header_words * 8;
+
+static uint64_t position_tag(uint64_t pos)
+{
+    return (pos / 8) & tag_mask;
+}
+
+static uint64_t make_header(uint64_t pos, uint64_t size_words, bool committed)
+{
+    return (position_tag(pos) << tag_shift) | (committed ? commit_flag : 0) | size_words;
+}
+
+static uint64_t mix(uint64_t hash, uint64_t value)
+{
+    hash = (hash ^ value) * 0x9e3779b97f4a7c15ull;
+    return hash ^ (hash >> 29);
+}
+
+size_t ByteRing::region_size(size_t capacity)
+{
+    return sizeof(ByteRingHeader) + (capacity + 7) / 8 * 8;
+}
+
+ByteRing::ByteRing(void *region, size_t capacity, bool init)
+    : ring_header{static_cast<ByteRingHeader*>(region)}
+    , words{reinterpret_cast<std::atomic<uint64_t>*>(static_cast<char*>(region) + sizeof(ByteRingHeader))}
+    , word_count{(capacity + 7) / 8}
+{
+    if (init) {
+        memset(region, 0, region_size(capacity));
+        new (&ring_header->head) std::atomic<uint64_t>(0);
+        new (&ring_header->read_pos) std::atomic<uint64_t>(0);
+        new (&ring_header->lost_bytes) std::atomic<uint64_t>(0);
+        ring_header->capacity = word_count * 8;
+        std::atomic_thread_fence(std::memory_order_release);
+        ring_header->magic = ring_magic;
+    }
+}
+
+bool ByteRing::valid() const
+{
+    return ring_header->magic == ring_magic && ring_header->capacity == word_count * 8 && word_count;
+}
+
+void ByteRing::push(int64_t time, LogLevel level, const char *text, size_t length)
+{
+    const uint64_t capacity = word_count * 8;
+    const uint64_t max_words = std::min<uint64_t>(capacity / 32, size_mask);
+    if (max_words <= record_header_words) {
+        return;
+    }
+    length = static_cast<size_t>(std::min<uint64_t>(length, (max_words - record_header_words) * 8));
+    uint64_t size_words = record_header_words + (length + 7) / 8;
+
+    uint64_t pos = ring_header->head.fetch_add(size_words * 8, std::memory_order_relaxed);
+    // the data stores can't be seen before the reservation
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint64_t meta = static_cast<uint64_t>(level) | (static_cast<uint64_t>(length) << 32);
+    uint64_t checksum = mix(mix(mix(0, pos), static_cast<uint64_t>(time)), meta);
+    word(pos).store(make_header(pos, size_words, false), std::memory_order_relaxed);
+    word(pos + 8).store(static_cast<uint64_t>(time), std::memory_order_relaxed);
+    word(pos + 16).store(meta, std::memory_order_relaxed);
+    for (size_t i = 0; i < length; i += 8) {
+        uint64_t value = 0;
+        memcpy(&value, text + i, std::min<size_t>(8, length - i));
+        checksum = mix(checksum, value);
+        word(pos + text_offset + i).store(value, std::memory_order_relaxed);
+    }
+    word(pos + 24).store(checksum, std::memory_order_relaxed);
+
+    // a writer lapped by the others doesn't commit the damaged record
+    if (ring_header->head.load(std::memory_order_relaxed) <= pos + capacity) {
+        word(pos).store(make_header(pos, size_words, true), std::memory_order_release);
+    }
+}
+
+uint64_t ByteRing::skip(uint64_t pos) const
+{
+    uint64_t value = word(pos).load(std::memory_order_acquire);
+    uint64_t size_words = value & size_mask;
+    if ((value >> tag_shift) == position_tag(pos) && size_words >= record_header_words) {
+        return pos + size_words * 8;
+    }
+    return pos + 8;
+}
+
+uint64_t ByteRing::read(uint64_t from, const std::function<void(RingRecord&&)> &callback,
+    uint64_t *lost, bool wait_pending) const
+{
+    const uint64_t capacity = word_count * 8;
+    uint64_t head = ring_header->head.load(std::memory_order_acquire);
+    uint64_t pos = from;
+    // the position is a record boundary until the reader has to jump over overwritten data
+    bool synced = true;
+
+    if (head > capacity && pos < head - capacity) {
+        if (lost) {
+            *lost += head - capacity - pos;
+        }
+        pos = head - capacity;
+        synced = false;
+    }
+
+    std::string text;
+    while (pos < head) {
+        uint64_t value = word(pos).load(std::memory_order_acquire);
+        uint64_t size_words = value & size_mask;
+        if ((value >> tag_shift) != position_tag(pos) || size_words < record_header_words
+            || pos + size_words * 8 > head)
+        {
+            if (synced && wait_pending) {
+                break;
+            }
+            pos += 8;
+            continue;
+        }
+        if (!(value & commit_flag)) {
+            if (wait_pending) {
+                break;
+            }
+            pos += size_words * 8;
+            continue;
+        }
+
+        int64_t time = static_cast<int64_t>(word(pos + 8).load(std::memory_order_relaxed));
+        uint64_t meta = word(pos + 16).load(std::memory_order_relaxed);
+        uint64_t stored_checksum = word(pos + 24).load(std::memory_order_relaxed);
+        uint64_t checksum = mix(mix(mix(0, pos), static_cast<uint64_t>(time)), meta);
+        size_t length = static_cast<size_t>(meta >> 32);
+        length = static_cast<size_t>(std::min<uint64_t>(length, (size_words - record_header_words) * 8));
+        text.resize(length);
+        for (size_t i = 0; i < length; i += 8) {
+            uint64_t data = word(pos + text_offset + i).load(std::memory_order_relaxed);
+            checksum = mix(checksum, data);
+            memcpy(&text[i], &data, std::min<size_t>(8, length - i));
+        }
+
+        // the record is valid if no writer has reserved its space since it was committed
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t current_head = ring_header->head.load(std::memory_order_relaxed);
+        if (current_head > pos + capacity) {
+            uint64_t next = std::max(pos + 8, current_head - capacity);
+            if (lost) {
+                *lost += next - pos;
+            }
+            pos = next;
+            synced = false;
+            continue;
+        }
+        if (checksum != stored_checksum) {
+            // a lapped writer has written into the record
+            if (lost) {
+                *lost += size_words * 8;
+            }
+            pos += size_words * 8;
+            continue;
+        }
+
+        synced = true;
+        callback(RingRecord{time, static_cast<LogLevel>(meta & 0xffffffff), std::move(text)});
+        text = std::string{};
+        pos += size_words * 8;
+    }
+    return pos;
+}
+
+} // namespace logging
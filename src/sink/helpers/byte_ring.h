@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <logging/sink/ring.h>
+
+namespace logging {
+
+/**
+ * @brief Header of the ring placed at the beginning of its memory region.
+ * 
+ */
+struct ByteRingHeader
+{
+    uint64_t magic;
+    uint64_t capacity;
+    std::atomic<uint64_t> head;         // bytes reserved by writers since the ring was created
+    std::atomic<uint64_t> read_pos;     // position of a consumer
+    std::atomic<uint64_t> lost_bytes;   // bytes overwritten before a consumer read them
+};
+
+/**
+ * @brief Lock-free multi-producer byte ring of log records.
+ * 
+ *  The ring is an array of 64-bit words, a record occupies whole words:
+ *  header (position tag, size, commit flag), time, level and length,
+ *  checksum, text. A writer reserves the record with fetch_add on the head,
+ *  writes it and sets the commit flag last. The oldest data is overwritten.
+ *  A reader validates the position tag of each record and drops the records
+ *  overwritten while they were read (seqlock check against the head).
+ *  A writer preempted after the reservation can be lapped and write into
+ *  newer records without moving the head, the checksum of the record and
+ *  its position detects that. The ring can be placed into shared memory.
+ */
+class ByteRing
+{
+public:
+
+    /**
+     * @brief Returns size of the memory region for the ring of given capacity.
+     * 
+     * @param capacity  size of data in bytes, rounded up to 8
+     * @return size_t 
+     */
+    static size_t region_size(size_t capacity);
+
+    /**
+     * @brief Construct a new Byte Ring object in the memory region.
+     * 
+     * @param region    memory region of region_size(capacity) bytes aligned to 8
+     * @param capacity 
+     * @param init      initialize the region, otherwise it's attached to
+     */
+    ByteRing(void *region, size_t capacity, bool init = true);
+
+    /**
+     * @brief Checks if the region contains a valid ring.
+     * 
+     * @return true 
+     * @return false 
+     */
+    bool valid() const;
+
+    /**
+     * @brief Writes the record, the text is truncated if it's larger than 1/4 of the capacity.
+     * 
+     * @param time 
+     * @param level 
+     * @param text 
+     * @param length 
+     */
+    void push(int64_t time, LogLevel level, const char *text, size_t length);
+
+    /**
+     * @brief Reads the committed records from the position up to the current head.
+     * 
+     * @param from          position to start from, a record boundary
+     * @param callback 
+     * @param lost          incremented by the number of bytes overwritten before they were read
+     * @param wait_pending  stop at a record that is not committed yet instead of skipping it
+     * @return uint64_t     the position after the read records
+     */
+    uint64_t read(uint64_t from, const std::function<void(RingRecord&&)> &callback,
+        uint64_t *lost = nullptr, bool wait_pending = false) const;
+
+    /**
+     * @brief Skips the record at the position, used when its writer is gone.
+     * 
+     * @param pos 
+     * @return uint64_t position of the next record
+     */
+    uint64_t skip(uint64_t pos) const;
+
+    ByteRingHeader* header() const { return ring_header; }
+
+    size_t capacity() const { return static_cast<size_t>(ring_header->capacity); }
+
+private:
+
+    ByteRingHeader *ring_header;
+    std::atomic<uint64_t> *words;
+    uint64_t word_count;
+
+    std::atomic<uint64_t>& word(uint64_t pos) const { return words[(pos / 8) % word_count]; }
+};
+
+} // namespace logging
@@ -0,0 +1,161 @@
+#include "compressed_file_writer.h"
+#include <iostream>
+#include "file_compressor.h"
+#ifdef LOGGING_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef LOGGING_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace logging {
+
+std::unique_ptr<LogFile> CompressedLogFile::create(const std::string& filename, Compression type)
+{
+    if (type == Compression::NONE || !is_compression_supported(type)) {
+        return nullptr;
+    }
+    return std::unique_ptr<LogFile>(new CompressedLogFile(filename, type));
+}
+
+CompressedLogFile::CompressedLogFile(const std::string& filename, Compression type)
+    : LogFile(filename)
+    , type{type}
+    , stream{nullptr}
+    , size{LogFile::disk_size()}
+{
+    file_stream.rdbuf()->pubsetbuf(nullptr, 0);
+    file_stream.open(file_path, std::ios::out | std::ios::app | std::ios::binary);
+
+    if (file_stream.fail()) {
+        std::cerr 
+            << "Can't open log file: "
+            << file_path
+            << std::endl;
+    }
+
+    switch (type) {
+#ifdef LOGGING_WITH_ZLIB
+        case Compression::GZIP:
+        {
+            auto zstream = new z_stream{};
+            // window bits + 16 writes the gzip header and trailer
+            if (deflateInit2(zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK) {
+                stream = zstream;
+            } else {
+                delete zstream;
+            }
+            break;
+        }
+#endif
+#ifdef LOGGING_WITH_ZSTD
+        case Compression::ZSTD:
+            stream = ZSTD_createCCtx();
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+CompressedLogFile::~CompressedLogFile()
+{
+    flush();
+
+    switch (type) {
+#ifdef LOGGING_WITH_ZLIB
+        case Compression::GZIP:
+            if (stream) {
+                deflateEnd(static_cast<z_stream*>(stream));
+                delete static_cast<z_stream*>(stream);
+            }
+            break;
+#endif
+#ifdef LOGGING_WITH_ZSTD
+        case Compression::ZSTD:
+            ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(stream));
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+void CompressedLogFile::write(FileRecordData &data)
+{
+    if (file_stream.fail() || !stream) {
+        return;
+    }
+
+    buffer.append(data.data);
+    buffer.append(1, '\n');
+    buffered = buffer.length();
+}
+
+void CompressedLogFile::flush()
+{
+    if (buffer.empty() || file_stream.fail()) {
+        return;
+    }
+
+    if (compress_frame()) {
+        file_stream.write(frame.data(), frame.size());
+        file_stream.flush();
+        size += frame.size();
+    } else {
+        std::cerr 
+            << "Can't compress log records: "
+            << file_path
+            << std::endl;
+    }
+    buffer.clear();
+    buffered = 0;
+}
+
+uint64_t CompressedLogFile::disk_size() const
+{
+    return size;
+}
+
+/**
+ * @brief Compresses the buffer into a complete frame.
+ * 
+ * @return true on success
+ */
+bool CompressedLogFile::compress_frame()
+{
+    switch (type) {
+#ifdef LOGGING_WITH_ZLIB
+        case Compression::GZIP:
+        {
+            auto zstream = static_cast<z_stream*>(stream);
+            frame.resize(deflateBound(zstream, static_cast<uLong>(buffer.size())));
+            zstream->next_in = reinterpret_cast<Bytef*>(buffer.data());
+            zstream->avail_in = static_cast<uInt>(buffer.size());
+            zstream->next_out = reinterpret_cast<Bytef*>(frame.data());
+            zstream->avail_out = static_cast<uInt>(frame.size());
+            int res = deflate(zstream, Z_FINISH);
+            frame.resize(frame.size() - zstream->avail_out);
+            // the next flush starts a new gzip member
+            deflateReset(zstream);
+            return res == Z_STREAM_END;
+        }
+#endif
+#ifdef LOGGING_WITH_ZSTD
+        case Compression::ZSTD:
+        {
+            frame.resize(ZSTD_compressBound(buffer.size()));
+            size_t size = ZSTD_compress2(static_cast<ZSTD_CCtx*>(stream), frame.data(), frame.size(), buffer.data(), buffer.size());
+            if (ZSTD_isError(size)) {
+                return false;
+            }
+            frame.resize(size);
+            return true;
+        }
+#endif
+        default:
+            return false;
+    }
+}
+
+} // namespace logging
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include "file_writer.h"
+
+namespace logging {
+
+/**
+ * @brief Log file that is written as a sequence of compressed frames.
+ * 
+ *  Buffered records are compressed into an independent gzip member or
+ *  zstd frame on every flush, so the file can be read by zcat/zstdcat
+ *  and a crash loses the unflushed records only. The sink flushes
+ *  the file when the buffered records reach its frame size.
+ */
+class CompressedLogFile : public LogFile
+{
+public:
+
+    /**
+     * @brief Creates the file, returns nullptr if the compression isn't available.
+     * 
+     * @param filename 
+     * @param type 
+     * @return std::unique_ptr<LogFile> 
+     */
+    static std::unique_ptr<LogFile> create(const std::string& filename, Compression type);
+
+    virtual ~CompressedLogFile();
+
+    virtual void write(FileRecordData &data) override;
+
+    virtual void flush() override;
+
+    /**
+     * @brief Returns the compressed size of the file, it's counted by the written frames.
+     * 
+     * @return uint64_t 
+     */
+    virtual uint64_t disk_size() const override;
+
+private:
+
+    CompressedLogFile(const std::string& filename, Compression type);
+
+    bool compress_frame();
+
+    Compression type;
+    std::fstream file_stream;
+    std::string buffer;
+    std::vector<char> frame;
+    void *stream;
+    uint64_t size;
+};
+
+} // namespace logging
@@ -0,0 +1,69 @@
+#include "deadline_timer.h"
+
+namespace logging {
+
+DeadlineTimer::~DeadlineTimer()
+{
+    stop();
+}
+
+void DeadlineTimer::schedule(time_point time, std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->time = time;
+        this->task = std::move(task);
+        ++generation;
+        if (!thread.joinable()) {
+            stopping = false;
+            thread = std::thread([this]() { run(); });
+        }
+    }
+    cv.notify_all();
+}
+
+void DeadlineTimer::cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = nullptr;
+        ++generation;
+    }
+    cv.notify_all();
+}
+
+void DeadlineTimer::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        task = nullptr;
+    }
+    cv.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void DeadlineTimer::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        if (!task) {
+            cv.wait(lock);
+            continue;
+        }
+        // a new task or the cancellation interrupts the waiting
+        uint64_t scheduled = generation;
+        if (cv.wait_until(lock, time, [this, scheduled]() { return stopping || generation != scheduled; })) {
+            continue;
+        }
+        auto current = std::move(task);
+        task = nullptr;
+        lock.unlock();
+        current();
+        lock.lock();
+    }
+}
+
+} // namespace logging
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+namespace logging {
+
+/**
+ * @brief Calls a task once at the given wall clock time in a background thread.
+ * 
+ *  The thread is started with the first scheduled task.
+ */
+class DeadlineTimer
+{
+public:
+
+    using time_point = std::chrono::system_clock::time_point;
+
+    DeadlineTimer() = default;
+
+    ~DeadlineTimer();
+
+    DeadlineTimer(const DeadlineTimer&) = delete;
+    DeadlineTimer& operator = (const DeadlineTimer&) = delete;
+
+    /**
+     * @brief Schedules the task, it replaces the task that isn't called yet.
+     * 
+     * @param time 
+     * @param task 
+     */
+    void schedule(time_point time, std::function<void()> task);
+
+    /**
+     * @brief Cancels the task that isn't called yet.
+     * 
+     */
+    void cancel();
+
+    void stop();
+
+private:
+
+    void run();
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::function<void()> task;
+    time_point time;
+    uint64_t generation = 0;
+    bool stopping = false;
+};
+
+} // namespace logging
@@ -0,0 +1,145 @@
+#include "fd_file_writer.h"
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+#include <sys/stat.h>
+#include "fd_io.h"
+
+namespace logging {
+
+#ifdef IOV_MAX
+constexpr size_t max_iov_count = IOV_MAX;
+#else
+constexpr size_t max_iov_count = 1024;
+#endif
+
+static char line_separator[] = "\n";
+
+FdLogFile::FdLogFile(const std::string& filename, size_t max_write_size)
+    : LogFile(filename)
+    , max_write_size{max_write_size}
+{
+    fd = ::open(file_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+
+    if (fd < 0) {
+        std::cerr 
+            << "Can't open log file: "
+            << file_path
+            << std::endl;
+    }
+}
+
+FdLogFile::~FdLogFile()
+{
+    flush();
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+void FdLogFile::write(FileRecordData &data)
+{
+    if (fd < 0) {
+        return;
+    }
+
+    if (!data.references.empty()) {
+        // the referenced texts are valid only during the call
+        write_records(&data);
+        return;
+    }
+
+    buffered += data.data.length() + 1;
+    records.push_back(std::move(data.data));
+}
+
+void FdLogFile::flush()
+{
+    write_records(nullptr);
+}
+
+/**
+ * @brief Writes the buffered records and the record with references after them.
+ *  Writes are split at record boundaries by max_write_size and the iovec limit.
+ * 
+ * @param referenced    record with references, nullptr if there isn't one
+ */
+void FdLogFile::write_records(const FileRecordData *referenced)
+{
+    if (records.empty() && !referenced) {
+        return;
+    }
+
+    std::vector<struct iovec> iov;
+    iov.reserve(std::min(records.size() * 2 + 2, max_iov_count));
+    size_t size = 0;
+    bool failed = false;
+
+    auto write_iov = [&]() {
+        if (!failed && !iov.empty() && !writev_all(fd, iov.data(), static_cast<int>(iov.size()))) {
+            std::cerr 
+                << "Can't write log file: "
+                << file_path
+                << std::endl;
+            failed = true;
+        }
+        iov.clear();
+        size = 0;
+    };
+    // starts a new write if the record doesn't fit into the current one
+    auto add_record = [&](size_t record_size, size_t iov_count) {
+        if (!iov.empty() && (iov.size() + iov_count > max_iov_count
+            || (max_write_size && size + record_size > max_write_size)))
+        {
+            write_iov();
+        }
+        size += record_size;
+    };
+
+    for (auto &record : records) {
+        add_record(record.length() + 1, 2);
+        iov.push_back({const_cast<char*>(record.data()), record.length()});
+        iov.push_back({line_separator, 1});
+    }
+
+    if (referenced) {
+        add_record(referenced->length() + 1, referenced->references.size() * 2 + 2);
+        const std::string &data = referenced->data;
+        size_t pos = 0;
+        for (auto &reference : referenced->references) {
+            if (reference.offset > pos) {
+                iov.push_back({const_cast<char*>(data.data() + pos), reference.offset - pos});
+            }
+            iov.push_back({const_cast<char*>(reference.text), reference.length});
+            pos = reference.offset;
+        }
+        if (pos < data.length()) {
+            iov.push_back({const_cast<char*>(data.data() + pos), data.length() - pos});
+        }
+        iov.push_back({line_separator, 1});
+    }
+    write_iov();
+
+    records.clear();
+    buffered = 0;
+}
+
+int FdLogFile::open_sync_handle()
+{
+    flush();
+    return duplicate_fd(fd);
+}
+
+bool FdLogFile::writes_references() const
+{
+    return true;
+}
+
+uint64_t FdLogFile::disk_size() const
+{
+    struct stat st;
+    return fd >= 0 && fstat(fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+}
+
+} // namespace logging
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include "file_writer.h"
+
+namespace logging {
+
+/**
+ * @brief Log file that is written through a POSIX file descriptor.
+ * 
+ *  The file is opened with O_APPEND | O_CLOEXEC. Buffered records
+ *  and their line separators are written with a single writev call.
+ *  With max_write_size the records are split into writes of whole records
+ *  up to that size, so each write is appended atomically when several
+ *  processes share the file.
+ *  A record with referenced texts is written at once together with
+ *  the buffered records, so the texts aren't copied.
+ */
+class FdLogFile : public LogFile
+{
+public:
+
+    FdLogFile(const std::string& filename, size_t max_write_size = 0);
+
+    virtual ~FdLogFile();
+
+    virtual void write(FileRecordData &data) override;
+
+    virtual void flush() override;
+
+    virtual int open_sync_handle() override;
+
+    virtual uint64_t disk_size() const override;
+
+    virtual bool writes_references() const override;
+
+private:
+
+    void write_records(const FileRecordData *referenced);
+
+    int fd;
+    size_t max_write_size;
+    std::vector<std::string> records;
+};
+
+} // namespace logging
@@ -0,0 +1,63 @@
+#include "fd_io.h"
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+
+namespace logging {
+
+bool write_all(int fd, const char *data, size_t size)
+{
+    while (size) {
+        ssize_t res = ::write(fd, data, size);
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += res;
+        size -= static_cast<size_t>(res);
+    }
+    return true;
+}
+
+bool writev_all(int fd, struct iovec *iov, int count)
+{
+    while (count) {
+        ssize_t res = ::writev(fd, iov, count);
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        size_t written = static_cast<size_t>(res);
+        while (count && written >= iov->iov_len) {
+            written -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+            iov->iov_len -= written;
+        }
+    }
+    return true;
+}
+
+int duplicate_fd(int fd)
+{
+    return fd < 0 ? -1 : fcntl(fd, F_DUPFD_CLOEXEC, 0);
+}
+
+bool sync_data(int fd)
+{
+#ifdef __APPLE__
+    int res = fsync(fd);
+#else
+    int res = fdatasync(fd);
+#endif
+    return res == 0;
+}
+
+} // namespace logging
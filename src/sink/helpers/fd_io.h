@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <sys/uio.h>
+
+namespace logging {
+
+/**
+ * @brief Writes all the data to the file descriptor.
+ *  Handles short writes and EINTR.
+ * 
+ * @param fd 
+ * @param data 
+ * @param size 
+ * @return true on success
+ */
+bool write_all(int fd, const char *data, size_t size);
+
+/**
+ * @brief Writes all the buffers to the file descriptor with writev.
+ *  Handles short writes and EINTR, the iov array is modified.
+ * 
+ * @param fd 
+ * @param iov 
+ * @param count 
+ * @return true on success
+ */
+bool writev_all(int fd, struct iovec *iov, int count);
+
+/**
+ * @brief Duplicates the file descriptor with FD_CLOEXEC.
+ * 
+ * @param fd 
+ * @return int  new descriptor, -1 on failure
+ */
+int duplicate_fd(int fd);
+
+/**
+ * @brief Syncs written data of the file to the storage device (fdatasync).
+ * 
+ * @param fd 
+ * @return true on success
+ */
+bool sync_data(int fd);
+
+} // namespace logging
@@ -0,0 +1,296 @@
+#include "file_compressor.h"
+#include <cstdio>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#ifdef LOGGING_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef LOGGING_WITH_ZSTD
+#include <zstd.h>
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+namespace logging {
+
+constexpr size_t compression_chunk_size = 256 * 1024;
+
+const char* compression_suffix(Compression type)
+{
+    switch (type) {
+        case Compression::GZIP: return ".gz";
+        case Compression::ZSTD: return ".zst";
+        case Compression::NONE: return "";
+    }
+    return "";
+}
+
+bool is_compression_supported(Compression type)
+{
+    switch (type) {
+        case Compression::NONE:
+            return true;
+        case Compression::GZIP:
+#ifdef LOGGING_WITH_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case Compression::ZSTD:
+#ifdef LOGGING_WITH_ZSTD
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+using FilePtr = std::unique_ptr<FILE, int(*)(FILE*)>;
+
+static FilePtr open_file(const std::string &filename, const char *mode)
+{
+    return FilePtr{fopen(filename.c_str(), mode), &fclose};
+}
+
+#ifdef LOGGING_WITH_ZLIB
+static bool compress_gzip(FILE *in, const std::string &dst)
+{
+    gzFile out = gzopen(dst.c_str(), "wb");
+    if (!out) {
+        return false;
+    }
+
+    std::vector<char> buffer(compression_chunk_size);
+    bool result = true;
+    size_t size;
+    while ((size = fread(buffer.data(), 1, buffer.size(), in)) > 0) {
+        if (gzwrite(out, buffer.data(), static_cast<unsigned>(size)) != static_cast<int>(size)) {
+            result = false;
+            break;
+        }
+    }
+    result = gzclose(out) == Z_OK && result && !ferror(in);
+    return result;
+}
+#endif
+
+#ifdef LOGGING_WITH_ZSTD
+static bool compress_zstd(FILE *in, const std::string &dst)
+{
+    auto out = open_file(dst, "wb");
+    std::unique_ptr<ZSTD_CCtx, size_t(*)(ZSTD_CCtx*)> cctx{ZSTD_createCCtx(), &ZSTD_freeCCtx};
+    if (!out || !cctx) {
+        return false;
+    }
+
+    std::vector<char> in_buffer(ZSTD_CStreamInSize());
+    std::vector<char> out_buffer(ZSTD_CStreamOutSize());
+    while (true) {
+        size_t size = fread(in_buffer.data(), 1, in_buffer.size(), in);
+        bool last = size < in_buffer.size();
+        ZSTD_inBuffer input{in_buffer.data(), size, 0};
+        bool finished;
+        do {
+            ZSTD_outBuffer output{out_buffer.data(), out_buffer.size(), 0};
+            size_t remaining = ZSTD_compressStream2(cctx.get(), &output, &input, last ? ZSTD_e_end : ZSTD_e_continue);
+            if (ZSTD_isError(remaining) || fwrite(out_buffer.data(), 1, output.pos, out.get()) != output.pos) {
+                return false;
+            }
+            finished = last ? remaining == 0 : input.pos == input.size;
+        } while (!finished);
+        if (last) {
+            break;
+        }
+    }
+    return !ferror(in) && fflush(out.get()) == 0;
+}
+#endif
+
+bool compress_file(const std::string &src, const std::string &dst, Compression type)
+{
+    auto in = open_file(src, "rb");
+    if (!in) {
+        return false;
+    }
+
+    switch (type) {
+#ifdef LOGGING_WITH_ZLIB
+        case Compression::GZIP: return compress_gzip(in.get(), dst);
+#endif
+#ifdef LOGGING_WITH_ZSTD
+        case Compression::ZSTD: return compress_zstd(in.get(), dst);
+#endif
+        default: return false;
+    }
+}
+
+/**
+ * @brief Appends the file to the destination file.
+ * 
+ * @param src 
+ * @param dst 
+ * @return true on success
+ */
+static bool append_file(const std::string &src, const std::string &dst)
+{
+    auto in = open_file(src, "rb");
+    auto out = open_file(dst, "ab");
+    if (!in || !out) {
+        return false;
+    }
+    std::vector<char> buffer(compression_chunk_size);
+    size_t size;
+    while ((size = fread(buffer.data(), 1, buffer.size(), in.get())) > 0) {
+        if (fwrite(buffer.data(), 1, size, out.get()) != size) {
+            return false;
+        }
+    }
+    return !ferror(in.get()) && fflush(out.get()) == 0;
+}
+
+/*
+ *
+ *  FileCompressor class
+ *
+ */
+
+std::shared_ptr<FileCompressor> FileCompressor::instance()
+{
+    static std::shared_ptr<FileCompressor> compressor{new FileCompressor()};
+    return compressor;
+}
+
+FileCompressor::FileCompressor()
+    : max_threads{1}
+    , idle_threads{0}
+    , stopping{false}
+{ }
+
+FileCompressor::~FileCompressor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    cv.notify_all();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void FileCompressor::set_max_threads(unsigned int count)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    max_threads = std::max(count, 1u);
+}
+
+void FileCompressor::compress(const void *owner, const std::string &filename, Compression type, Callback done)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back({owner, filename, type, std::move(done)});
+        if (!idle_threads && threads.size() < max_threads) {
+            threads.emplace_back(&FileCompressor::run, this);
+        }
+    }
+    cv.notify_one();
+}
+
+bool FileCompressor::has_jobs(const void *owner) const
+{
+    auto it = running.find(owner);
+    if (it != running.end() && it->second) {
+        return true;
+    }
+    return std::any_of(jobs.begin(), jobs.end(), [owner](const Job &job) { return job.owner == owner; });
+}
+
+void FileCompressor::wait(const void *owner)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this, owner]() { return !has_jobs(owner); });
+}
+
+void FileCompressor::cancel(const void *owner)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    jobs.erase(
+        std::remove_if(jobs.begin(), jobs.end(), [owner](const Job &job) { return job.owner == owner; }),
+        jobs.end()
+    );
+    done_cv.wait(lock, [this, owner]() { return !has_jobs(owner); });
+}
+
+void FileCompressor::run()
+{
+#ifdef __linux__
+    // the nice value is per thread on linux
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#endif
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        ++idle_threads;
+        cv.wait(lock, [this]() { return stopping || !jobs.empty(); });
+        --idle_threads;
+        if (stopping) {
+            break;
+        }
+
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        ++running[job.owner];
+        lock.unlock();
+
+        std::string compressed = job.filename + compression_suffix(job.type);
+        std::string tmp = compressed + ".tmp";
+        std::error_code code;
+        if (compress_file(job.filename, tmp, job.type)) {
+            {
+                // a template can produce the name again (e.g. %H on the next day), the existing
+                // archive is never replaced, the new gzip member or zstd frame is appended to it
+                std::lock_guard<std::mutex> archive_lock(archive_mutex);
+                if (std::filesystem::exists(compressed, code)) {
+                    if (!append_file(tmp, compressed)) {
+                        code = std::make_error_code(std::errc::io_error);
+                    }
+                    std::error_code remove_code;
+                    std::filesystem::remove(tmp, remove_code);
+                } else {
+                    std::filesystem::rename(tmp, compressed, code);
+                }
+            }
+            if (code) {
+                std::cerr 
+                    << "Can't store compressed log file: "
+                    << compressed
+                    << std::endl;
+            } else {
+                std::filesystem::remove(job.filename, code);
+                auto size = std::filesystem::file_size(compressed, code);
+                job.done(compressed, code ? 0 : size);
+            }
+        } else {
+            std::cerr 
+                << "Can't compress log file: "
+                << job.filename
+                << std::endl;
+            std::filesystem::remove(tmp, code);
+        }
+
+        lock.lock();
+        if (--running[job.owner] == 0) {
+            running.erase(job.owner);
+        }
+        done_cv.notify_all();
+    }
+}
+
+} // namespace logging
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+#include <logging/sink/file.h>
+
+namespace logging {
+
+/**
+ * @brief Returns the file name suffix of the compression type (".gz", ".zst").
+ * 
+ * @param type 
+ * @return const char* 
+ */
+const char* compression_suffix(Compression type);
+
+/**
+ * @brief Checks if the compression type is available in the build.
+ * 
+ * @param type 
+ * @return true 
+ * @return false 
+ */
+bool is_compression_supported(Compression type);
+
+/**
+ * @brief Compresses a file into the destination file.
+ * 
+ * @param src 
+ * @param dst 
+ * @param type 
+ * @return true on success
+ */
+bool compress_file(const std::string &src, const std::string &dst, Compression type);
+
+/**
+ * @brief Process-wide pool of threads compressing closed log files.
+ * 
+ *  The number of threads is limited (1 by default), the threads run
+ *  with the lowest scheduling priority, so compression doesn't compete
+ *  with the application threads.
+ */
+class FileCompressor
+{
+public:
+
+    /**
+     * @brief Callback is called with the compressed file name and its size.
+     * 
+     */
+    using Callback = std::function<void(const std::string &compressed_filename, uint64_t size)>;
+
+    /**
+     * @brief Returns the process-wide pool. Users keep the returned pointer,
+     *  so the pool outlives them even when they are static objects.
+     * 
+     * @return std::shared_ptr<FileCompressor> 
+     */
+    static std::shared_ptr<FileCompressor> instance();
+
+    ~FileCompressor();
+
+    void set_max_threads(unsigned int count);
+
+    /**
+     * @brief Queues compression of the file, the file is replaced with
+     *  the compressed one when it's done. If the compressed file exists,
+     *  the new member or frame is appended to it.
+     * 
+     * @param owner     owner of the job, used to wait for or cancel its jobs
+     * @param filename 
+     * @param type 
+     * @param done      called from the compression thread on success
+     */
+    void compress(const void *owner, const std::string &filename, Compression type, Callback done);
+
+    /**
+     * @brief Waits until all jobs of the owner are completed.
+     * 
+     * @param owner 
+     */
+    void wait(const void *owner);
+
+    /**
+     * @brief Removes the queued jobs of the owner, waits for the running ones.
+     * 
+     * @param owner 
+     */
+    void cancel(const void *owner);
+
+private:
+
+    FileCompressor();
+
+    struct Job
+    {
+        const void *owner;
+        std::string filename;
+        Compression type;
+        Callback done;
+    };
+
+    void run();
+    bool has_jobs(const void *owner) const;
+
+    std::mutex mutex;
+    std::mutex archive_mutex;
+    std::condition_variable cv;
+    std::condition_variable done_cv;
+    std::deque<Job> jobs;
+    std::vector<std::thread> threads;
+    std::map<const void*, unsigned int> running;
+    unsigned int max_threads;
+    unsigned int idle_threads;
+    bool stopping;
+};
+
+} // namespace logging
@@ -0,0 +1,31 @@
+#include "file_lock.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+
+namespace logging {
+
+FileLock::FileLock(const std::string &path, bool wait)
+    : fd{::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)}
+    , locked{false}
+{
+    if (fd < 0) {
+        return;
+    }
+    int res;
+    do {
+        res = flock(fd, LOCK_EX | (wait ? 0 : LOCK_NB));
+    } while (res != 0 && errno == EINTR);
+    locked = res == 0;
+}
+
+FileLock::~FileLock()
+{
+    if (fd >= 0) {
+        // closing the descriptor releases the lock
+        ::close(fd);
+    }
+}
+
+} // namespace logging
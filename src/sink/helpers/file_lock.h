@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+
+namespace logging {
+
+/**
+ * @brief Exclusive advisory lock of a file (flock), released on destruction.
+ * 
+ *  The lock file is created if it doesn't exist. Each object opens its own
+ *  descriptor, so objects of the same process exclude each other as well.
+ */
+class FileLock
+{
+public:
+
+    /**
+     * @brief Opens the lock file and locks it.
+     * 
+     * @param path 
+     * @param wait  wait for the lock, otherwise owns_lock() is false if it's locked by someone else
+     */
+    FileLock(const std::string &path, bool wait = true);
+
+    ~FileLock();
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator = (const FileLock&) = delete;
+
+    bool owns_lock() const { return locked; }
+
+private:
+
+    int fd;
+    bool locked;
+};
+
+} // namespace logging
@@ -0,0 +1,175 @@
+#include "file_retention.h"
+#include <iostream>
+#include "convert_str.h"
+
+namespace logging {
+
+bool FileRetention::Entry::operator < (const Entry &rhs) const
+{
+    if (params < rhs.params) {
+        return true;
+    }
+    if (rhs.params < params) {
+        return false;
+    }
+    return path < rhs.path;
+}
+
+FileRetention::FileRetention(const FilenameTemplate &filename_template)
+    : filename_template{filename_template}
+    , max_files{0}
+    , max_bytes{0}
+    , total_size{0}
+{ }
+
+void FileRetention::set_limits(unsigned int max_files, uint64_t max_bytes)
+{
+    this->max_files = max_files;
+    this->max_bytes = max_bytes;
+}
+
+void FileRetention::file_opened(const std::filesystem::path &path, uint64_t size)
+{
+    if (!enabled() || !filename_template.rotatable()) {
+        return;
+    }
+
+    auto dir = path.parent_path();
+    if (dir != index_dir || files.empty()) {
+        build(dir);
+    }
+
+    auto name = convert_str<std::string>(path.filename().u8string());
+    auto params = filename_template.parse_filename(name);
+    if (params.has_value()) {
+        auto it = files.insert({params.value(), path, 0}).first;
+        total_size += size - it->size;
+        it->size = size;
+    }
+
+    remove_old_files(path);
+}
+
+void FileRetention::file_closed(const std::filesystem::path &path, uint64_t size)
+{
+    auto it = find(path);
+    if (it != files.end()) {
+        total_size += size - it->size;
+        it->size = size;
+    }
+}
+
+void FileRetention::file_compressed(const std::filesystem::path &path, const std::filesystem::path &compressed_path, uint64_t size)
+{
+    if (!enabled()) {
+        return;
+    }
+    file_removed(path);
+    if (compressed_path.parent_path() != index_dir) {
+        return;
+    }
+    auto name = convert_str<std::string>(compressed_path.filename().u8string());
+    auto params = filename_template.parse_filename(name);
+    if (params.has_value()) {
+        auto it = files.insert({params.value(), compressed_path, 0}).first;
+        total_size += size - it->size;
+        it->size = size;
+    }
+}
+
+void FileRetention::file_removed(const std::filesystem::path &path)
+{
+    auto it = find(path);
+    if (it != files.end()) {
+        total_size -= it->size;
+        files.erase(it);
+    }
+}
+
+void FileRetention::invalidate()
+{
+    files.clear();
+    total_size = 0;
+    index_dir.clear();
+}
+
+/**
+ * @brief Scans the directory for the files matching the template.
+ * 
+ * @param dir 
+ */
+void FileRetention::build(const std::filesystem::path &dir)
+{
+    files.clear();
+    total_size = 0;
+    index_dir = dir;
+
+    std::error_code code;
+    for (auto& p: std::filesystem::directory_iterator(dir.empty() ? "." : dir, code)) {
+        if (p.is_regular_file(code)) {
+            auto name = convert_str<std::string>(p.path().filename().u8string());
+            auto params = filename_template.parse_filename(name);
+            if (params.has_value()) {
+                auto size = p.file_size(code);
+                size = code ? 0 : size;
+                files.insert({params.value(), dir / p.path().filename(), size});
+                total_size += size;
+            }
+        }
+    }
+}
+
+std::set<FileRetention::Entry>::iterator FileRetention::find(const std::filesystem::path &path)
+{
+    auto name = convert_str<std::string>(path.filename().u8string());
+    auto params = filename_template.parse_filename(name);
+    if (!params.has_value()) {
+        return files.end();
+    }
+    return files.find({params.value(), path, 0});
+}
+
+/**
+ * @brief Removes the oldest files until the index fits the limits, the current file is kept.
+ *  Files after the current one were opened ahead of it, they count when they become current.
+ * 
+ * @param current 
+ */
+void FileRetention::remove_old_files(const std::filesystem::path &current)
+{
+    auto end = find(current);
+    if (end != files.end()) {
+        ++end;
+    }
+    size_t count = 0;
+    uint64_t size = 0;
+    for (auto it = files.begin(); it != end; ++it) {
+        ++count;
+        size += it->size;
+    }
+
+    auto it = files.begin();
+    while (it != end
+        && ((max_files && count > max_files) || (max_bytes && size > max_bytes)))
+    {
+        if (it->path == current) {
+            ++it;
+            continue;
+        }
+
+        std::error_code code;
+        if (!std::filesystem::remove(it->path, code) && code) {
+            std::cerr 
+                << "Can't remove old log file: " 
+                << it->path 
+                << ", code: " << code
+                << std::endl;
+        }
+        total_size -= it->size;
+        size -= it->size;
+        --count;
+        it = files.erase(it);
+    }
+}
+
+} // namespace logging
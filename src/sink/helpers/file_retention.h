@@ -0,0 +1,93 @@
+#pragma once
+
+#include <set>
+#include <string>
+#include <cstdint>
+#include <filesystem>
+#include "filename_template.h"
+
+namespace logging {
+
+/**
+ * @brief Sorted index of log files matching a filename template.
+ * 
+ *  The index of a directory is built once, when the first file in it is opened,
+ *  and then it's updated when files are created and deleted. Files beyond
+ *  the limits (number of files, total size) are removed, the oldest first.
+ *  The class isn't thread-safe, FileSink uses it from its background worker only.
+ */
+class FileRetention
+{
+public:
+
+    FileRetention(const FilenameTemplate &filename_template);
+
+    void set_limits(unsigned int max_files, uint64_t max_bytes);
+
+    bool enabled() const { return max_files || max_bytes; }
+
+    /**
+     * @brief Adds the new current file to the index and removes old files.
+     * 
+     * @param path          path of the opened file
+     * @param size          size of the opened file
+     */
+    void file_opened(const std::filesystem::path &path, uint64_t size);
+
+    /**
+     * @brief Updates size of a closed file.
+     * 
+     * @param path 
+     * @param size 
+     */
+    void file_closed(const std::filesystem::path &path, uint64_t size);
+
+    /**
+     * @brief Replaces the file with its compressed copy in the index.
+     * 
+     * @param path              path of the original file
+     * @param compressed_path   path of the compressed file
+     * @param size              size of the compressed file
+     */
+    void file_compressed(const std::filesystem::path &path, const std::filesystem::path &compressed_path, uint64_t size);
+
+    /**
+     * @brief Removes the file from the index.
+     * 
+     * @param path 
+     */
+    void file_removed(const std::filesystem::path &path);
+
+    /**
+     * @brief Drops the index, the directory is scanned again when the next file is opened.
+     *  It's used when other processes change the files of the directory.
+     * 
+     */
+    void invalidate();
+
+    size_t size() const { return files.size(); }
+
+private:
+
+    struct Entry
+    {
+        TemplateFileParams params;
+        std::filesystem::path path;
+        mutable uint64_t size;
+
+        bool operator < (const Entry &rhs) const;
+    };
+
+    const FilenameTemplate &filename_template;
+    unsigned int max_files;
+    uint64_t max_bytes;
+    uint64_t total_size;
+    std::filesystem::path index_dir;
+    std::set<Entry> files;
+
+    void build(const std::filesystem::path &dir);
+    std::set<Entry>::iterator find(const std::filesystem::path &path);
+    void remove_old_files(const std::filesystem::path &current);
+};
+
+} // namespace logging
@@ -1,6 +1,16 @@
 #include "file_writer.h"
 #include <iostream>
 #include "convert_str.h"
+#include "compressed_file_writer.h"
+#ifdef __unix__
+#include <fcntl.h>
+#include "fd_file_writer.h"
+#include "mmap_file_writer.h"
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#include "uring_file_writer.h"
+#endif
 
 using namespace std;
 
@@ -16,10 +26,99 @@ void FileRecordData::reserve(unsigned long size)
     data.reserve(size);
 }
 
+void FileRecordData::append_text(const char* text, size_t length)
+{
+    data.append(text, length);
+}
+
+void FileRecordData::append_fill(char fill, size_t count)
+{
+    data.append(count, fill);
+}
+
+void FileRecordData::append_reference(const char* text, size_t length)
+{
+    if (length < min_reference_length) {
+        data.append(text, length);
+        return;
+    }
+    references.push_back({data.length(), text, length});
+    referenced_length += length;
+}
+
+void FileRecordData::resolve_references()
+{
+    if (references.empty()) {
+        return;
+    }
+    std::string result;
+    result.reserve(length());
+    size_t pos = 0;
+    for (auto &reference : references) {
+        result.append(data, pos, reference.offset - pos);
+        result.append(reference.text, reference.length);
+        pos = reference.offset;
+    }
+    result.append(data, pos, std::string::npos);
+    data = std::move(result);
+    references.clear();
+    referenced_length = 0;
+}
+
+/*
+ *
+ *  LogFile class
+ *
+ */
+
 LogFile::LogFile(const std::string& filename)
     : file_path(filename)
+    , buffered(0)
 { 
     file_path.make_preferred();
+}
+
+LogFile::~LogFile() = default;
+
+uint64_t LogFile::disk_size() const
+{
+    std::error_code code;
+    auto size = std::filesystem::file_size(file_path, code);
+    return code ? 0 : size;
+}
+
+bool LogFile::writes_references() const
+{
+    return false;
+}
+
+int LogFile::open_sync_handle()
+{
+    flush();
+#ifdef __unix__
+    // fdatasync on any descriptor syncs the data written through the others
+    return ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+#else
+    return -1;
+#endif
+}
+
+std::string LogFile::get_filename() const
+{
+    return convert_str<std::string>(file_path.u8string());
+}
+
+/*
+ *
+ *  StreamLogFile class
+ *
+ */
+
+StreamLogFile::StreamLogFile(const std::string& filename)
+    : LogFile(filename)
+{ 
+    // records are buffered by LogFile, so the stream buffer is disabled
+    file_stream.rdbuf()->pubsetbuf(nullptr, 0);
     file_stream.open(file_path, ios::out | ios::app | ios::binary);
 
     if (file_stream.fail()) {
@@ -30,23 +129,83 @@ LogFile::LogFile(const std::string& filename)
     }
 }
 
-LogFile::~LogFile()
-{ }
+StreamLogFile::~StreamLogFile()
+{
+    flush();
+}
     
-void LogFile::write(FileRecordData &data)
+void StreamLogFile::write(FileRecordData &data)
 {
     if (file_stream.fail()) {
         return;
     }
 
-    file_stream.write(data.data.c_str(), data.data.length());
-    file_stream.write("\n", 1);
+    buffer.append(data.data);
+    buffer.append(1, '\n');
+    buffered = buffer.length();
+}
+
+void StreamLogFile::flush()
+{
+    if (buffer.empty() || file_stream.fail()) {
+        return;
+    }
+
+    file_stream.write(buffer.c_str(), buffer.length());
     file_stream.flush();
+    buffer.clear();
+    buffered = 0;
 }
 
-std::string LogFile::get_filename() const
+/*
+ *
+ *  Log file factory
+ *
+ */
+
+std::unique_ptr<LogFile> make_log_file(FileWriter writer, const std::string& filename,
+    Compression compression, size_t max_write_size)
 {
-    return convert_str<std::string>(file_path.u8string());
+    if (compression != Compression::NONE) {
+        if (auto file = CompressedLogFile::create(filename, compression)) {
+            return file;
+        }
+    }
+
+    switch (writer) {
+#ifdef __unix__
+        case FileWriter::FD:
+            return std::make_unique<FdLogFile>(filename, max_write_size);
+        case FileWriter::MMAP:
+            return std::make_unique<MmapLogFile>(filename);
+#endif
+#ifdef __linux__
+        case FileWriter::URING:
+            if (auto file = UringLogFile::create(filename)) {
+                return file;
+            }
+            return std::make_unique<FdLogFile>(filename);
+#endif
+        default:
+            return std::make_unique<StreamLogFile>(filename);
+    }
+}
+
+bool preallocate_file(const std::string& filename, uint64_t size)
+{
+#ifdef __linux__
+    int fd = ::open(filename.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool result = ::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size)) == 0;
+    ::close(fd);
+    return result;
+#else
+    (void)filename;
+    (void)size;
+    return false;
+#endif
 }
 
 } // namespace logging
\ No newline at end of file
@@ -1,20 +1,64 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <memory>
+#include <cstdint>
 #include <fstream>
 #include <filesystem>
 #include <logging/logging.h>
+#include <logging/sink/file.h>
 
 namespace logging {
 
+/**
+ * @brief Minimum length of the record text that is referenced instead of copied.
+ * 
+ */
+constexpr size_t min_reference_length = 4096;
+
+/**
+ * @brief Formatted record. Large texts of the record are kept as references,
+ *  they're inserted at their offsets of data and valid only until the sink's write returns.
+ */
 struct FileRecordData : public ITextData
 {
+    struct Reference
+    {
+        size_t offset;
+        const char *text;
+        size_t length;
+    };
+
     std::string data;
+    std::vector<Reference> references;
+    size_t referenced_length = 0;
+
     virtual void append(const char* text) override;
     virtual void reserve(unsigned long size) override;
+    virtual void append_text(const char* text, size_t length) override;
+    virtual void append_fill(char fill, size_t count) override;
+    virtual void append_reference(const char* text, size_t length) override;
+
+    /**
+     * @brief Returns the length of the record text including the references.
+     * 
+     * @return size_t 
+     */
+    size_t length() const { return data.length() + referenced_length; }
+
+    /**
+     * @brief Copies the referenced texts into data.
+     * 
+     */
+    void resolve_references();
 };
 
+/**
+ * @brief Base class of log files.
+ * 
+ *  A log file buffers written records until flush() is called.
+ */
 class LogFile
 {
 public:
@@ -23,15 +67,88 @@ public:
 
     virtual ~LogFile();
     
-    virtual void write(FileRecordData &data);
+    virtual void write(FileRecordData &data) = 0;
+
+    virtual void flush() = 0;
+
+    /**
+     * @brief Flushes the file and returns a new descriptor of it to sync the written
+     *  data without holding the file. The caller closes the descriptor.
+     * 
+     * @return int  file descriptor, -1 if syncing isn't supported
+     */
+    virtual int open_sync_handle();
+
+    /**
+     * @brief Returns the size of the file on disk, it includes data appended by other processes.
+     * 
+     * @return uint64_t 
+     */
+    virtual uint64_t disk_size() const;
+
+    /**
+     * @brief Checks if the file writes the referenced texts of the record in write(),
+     *  otherwise they're copied into the record before the call.
+     * 
+     * @return true 
+     * @return false 
+     */
+    virtual bool writes_references() const;
+
+    size_t buffered_size() const { return buffered; }
 
     std::string get_filename() const;
     
-private:
+protected:
 
     std::filesystem::path file_path;
+    size_t buffered;
+};
+
+/**
+ * @brief Log file that is written through std::fstream.
+ * 
+ */
+class StreamLogFile : public LogFile
+{
+public:
+
+    StreamLogFile(const std::string& filename);
+
+    virtual ~StreamLogFile();
+
+    virtual void write(FileRecordData &data) override;
+
+    virtual void flush() override;
+
+private:
+
     std::fstream file_stream;
+    std::string buffer;
 };
 
+/**
+ * @brief Creates a log file of the given writer type.
+ *  Falls back to StreamLogFile if the writer isn't supported on the platform.
+ *  A compressed file is written as a stream of frames, the writer type is ignored.
+ * 
+ * @param writer 
+ * @param filename 
+ * @param compression 
+ * @param max_write_size    maximum size of a single write of the FD writer, 0 - unlimited
+ * @return std::unique_ptr<LogFile> 
+ */
+std::unique_ptr<LogFile> make_log_file(FileWriter writer, const std::string& filename,
+    Compression compression = Compression::NONE, size_t max_write_size = 0);
+
+/**
+ * @brief Allocates disk blocks for the file without changing its size (linux only),
+ *  so appends up to that size don't allocate blocks and update the file metadata.
+ * 
+ * @param filename 
+ * @param size 
+ * @return true on success
+ */
+bool preallocate_file(const std::string& filename, uint64_t size);
 
-} // namespace logging
\ No newline at end of file
+} // namespace logging
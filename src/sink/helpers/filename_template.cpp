@@ -1,5 +1,6 @@
 #include "filename_template.h"
 #include <cstring>
+#include <algorithm>
 #include <logging/sink/file_template_exception.h>
 
 const char* logging::FileTemplateException::what() const noexcept
@@ -16,6 +17,8 @@ enum class TemplateTokenType
     DAY,
     YDAY,
     HOUR,
+    INDEX,
+    THREAD,
 };
 
 const char* get_token_type_format(TemplateTokenType type)
@@ -27,6 +30,8 @@ const char* get_token_type_format(TemplateTokenType type)
         case TemplateTokenType::YDAY:   return "%j";
         case TemplateTokenType::WEEK:   return "%W";
         case TemplateTokenType::HOUR:   return "%H";
+        case TemplateTokenType::INDEX:  return "";
+        case TemplateTokenType::THREAD: return "";
         case TemplateTokenType::TEXT:   return "";
     }
     return "";
@@ -41,18 +46,12 @@ TemplateTokenType get_token_type(char fmt_char)
         case 'j': return TemplateTokenType::YDAY;
         case 'W': return TemplateTokenType::WEEK;
         case 'H': return TemplateTokenType::HOUR;
+        case 'i': return TemplateTokenType::INDEX;
+        case 't': return TemplateTokenType::THREAD;
     }
     throw logging::FileTemplateException("Wrong file template format");
 }
 
-bool is_equal_weeks(const std::tm& tm1, const std::tm& tm2)
-{
-    char w1[3], w2[3];
-    std::strftime(w1, sizeof(w1), "%W", &tm1);
-    std::strftime(w2, sizeof(w2), "%W", &tm2);
-    return *(unsigned short*)w1 == *(unsigned short*)w2;
-}
-
 bool TemplateFileParams::operator < (const TemplateFileParams &rhs) const
 {
     if (year != rhs.year) {
@@ -71,11 +70,21 @@ bool TemplateFileParams::operator < (const TemplateFileParams &rhs) const
         return week < rhs.week;
     }
     
-    return hour < rhs.hour;
+    if (hour != rhs.hour) {
+        return hour < rhs.hour;
+    }
+
+    if (index != rhs.index) {
+        return index < rhs.index;
+    }
+
+    return thread < rhs.thread;
 }
 
 FilenameTemplate::FilenameTemplate(const std::string& filename_template)
     : is_rotatable{false}
+    , is_indexed{false}
+    , is_threaded{false}
     , name_start_token{0}
     , name_pos{0}
     , template_tokens{}
@@ -105,7 +114,12 @@ FilenameTemplate::FilenameTemplate(const std::string& filename_template)
         auto type = get_token_type(file_template[p]);
         update_name_start(np, start, p + 1);
         template_tokens.emplace_back(type);
-        is_rotatable = true;
+        if (type == TemplateTokenType::THREAD) {
+            is_threaded = true;
+        } else {
+            is_rotatable = true;
+        }
+        is_indexed = is_indexed || type == TemplateTokenType::INDEX;
         p++;
         start = p;
     }
@@ -127,51 +141,98 @@ void FilenameTemplate::update_name_start(size_t &name_start, size_t start, size_
     }
 }
 
-bool FilenameTemplate::is_need_rotate(const std::tm& tm, const std::tm& current_tm) const
+/**
+ * @brief Converts the local datetime to milliseconds since epoch.
+ * 
+ * @param tm        datetime, the fields may be out of their ranges
+ * @param isdst     DST flag, -1 - it's determined by mktime
+ * @return int64_t 
+ */
+static int64_t local_time_ms(std::tm tm, int isdst = -1)
 {
-    if (is_rotatable) {
-        for (auto& token : template_tokens) {
-            switch (token.type) {
-                case TemplateTokenType::DAY:
-                case TemplateTokenType::YDAY:
-                    if (current_tm.tm_yday != tm.tm_yday || 
-                        current_tm.tm_year != tm.tm_year)
-                        return true;
-                break;
-                case TemplateTokenType::MONTH:
-                    if (current_tm.tm_mon != tm.tm_mon ||
-                        current_tm.tm_year != tm.tm_year)
-                        return true;
-                break;
-                case TemplateTokenType::YEAR:
-                    if (current_tm.tm_year != tm.tm_year)
-                        return true;
-                break;
-                case TemplateTokenType::HOUR:
-                    if (current_tm.tm_hour != tm.tm_hour || 
-                        current_tm.tm_yday != tm.tm_yday || 
-                        current_tm.tm_year != tm.tm_year)
-                        return true;
-                break;
-                case TemplateTokenType::WEEK:
-                    if (!is_equal_weeks(current_tm, tm))
-                        return true;
-                break;
-                default: break;
+    tm.tm_isdst = isdst;
+    return static_cast<int64_t>(std::mktime(&tm)) * 1000;
+}
+
+RotationPeriod FilenameTemplate::get_rotation_period(const std::tm& tm) const
+{
+    RotationPeriod period;
+    if (!is_rotatable) {
+        return period;
+    }
+
+    auto update = [&period](int64_t start_ms, int64_t end_ms) {
+        period.start_ms = std::max(period.start_ms, start_ms);
+        period.end_ms = std::min(period.end_ms, end_ms);
+    };
+
+    std::tm day = tm;
+    day.tm_hour = day.tm_min = day.tm_sec = 0;
+    std::tm year = day;
+    year.tm_mon = 0;
+    year.tm_mday = 1;
+    std::tm next_year = year;
+    ++next_year.tm_year;
+
+    for (auto& token : template_tokens) {
+        switch (token.type) {
+            case TemplateTokenType::HOUR:
+            {
+                std::tm start = tm;
+                start.tm_min = start.tm_sec = 0;
+                std::tm end = start;
+                ++end.tm_hour;
+                // the hour has the DST flag of the record, it matters when the hour is repeated
+                update(local_time_ms(start, tm.tm_isdst), local_time_ms(end));
+                break;
+            }
+            case TemplateTokenType::DAY:
+            case TemplateTokenType::YDAY:
+            {
+                std::tm end = day;
+                ++end.tm_mday;
+                update(local_time_ms(day), local_time_ms(end));
+                break;
+            }
+            case TemplateTokenType::WEEK:
+            {
+                // weeks start on Monday, the first week of the year starts on January 1
+                std::tm start = day;
+                start.tm_mday -= (tm.tm_wday + 6) % 7;
+                std::tm end = start;
+                end.tm_mday += 7;
+                update(std::max(local_time_ms(start), local_time_ms(year)),
+                    std::min(local_time_ms(end), local_time_ms(next_year)));
+                break;
             }
+            case TemplateTokenType::MONTH:
+            {
+                std::tm start = day;
+                start.tm_mday = 1;
+                std::tm end = start;
+                ++end.tm_mon;
+                update(local_time_ms(start), local_time_ms(end));
+                break;
+            }
+            case TemplateTokenType::YEAR:
+                update(local_time_ms(year), local_time_ms(next_year));
+                break;
+            default:
+                break;
         }
     }
-
-    return false;
+    return period;
 }
 
-std::string FilenameTemplate::generate_filename(const std::tm& tm) const
+std::string FilenameTemplate::generate_filename(const std::tm& tm, unsigned int index) const
 {
     std::string result;
     char tmp[8];
     for (auto& token : template_tokens) {
         const char* fmt = get_token_type_format(token.type);
-        if (fmt[0]) {
+        if (token.type == TemplateTokenType::INDEX) {
+            result += std::to_string(index);
+        } else if (fmt[0]) {
             strftime(tmp, sizeof(tmp), fmt, &tm);
             result += tmp;
         } else {
@@ -181,6 +242,28 @@ std::string FilenameTemplate::generate_filename(const std::tm& tm) const
     return result;
 }
 
+std::string FilenameTemplate::bind_thread(unsigned int thread) const
+{
+    std::string result;
+    for (auto& token : template_tokens) {
+        switch (token.type) {
+            case TemplateTokenType::TEXT:
+                result += token.text;
+                break;
+            case TemplateTokenType::INDEX:
+                result += "%i";
+                break;
+            case TemplateTokenType::THREAD:
+                result += std::to_string(thread);
+                break;
+            default:
+                result += get_token_type_format(token.type);
+                break;
+        }
+    }
+    return result;
+}
+
 static bool parse_int(const char *str, int count, int &result)
 {
     int res = 0;
@@ -197,7 +280,7 @@ static bool parse_int(const char *str, int count, int &result)
 }
 
 std::optional<TemplateFileParams>
-    FilenameTemplate::parse_filename(const std::string &filename)
+    FilenameTemplate::parse_filename(const std::string &filename) const
 {
     const char *cstr = filename.c_str();
     TemplateFileParams params;
@@ -248,7 +331,25 @@ std::optional<TemplateFileParams>
                 }
                 cstr += 2;
                 break;
+            case TemplateTokenType::INDEX:
+            case TemplateTokenType::THREAD:
+            {
+                int count = 0;
+                while (cstr[count] >= '0' && cstr[count] <= '9' && count < 9) {
+                    ++count;
+                }
+                int &value = token.type == TemplateTokenType::INDEX ? params.index : params.thread;
+                if (!count || !parse_int(cstr, count, value)) {
+                    return std::nullopt;
+                }
+                cstr += count;
+                break;
+            }
         }
     }
+    // rotated files may be compressed
+    if (*cstr && strcmp(cstr, ".gz") != 0 && strcmp(cstr, ".zst") != 0) {
+        return std::nullopt;
+    }
     return params;
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <ctime>
 #include <vector>
 #include <optional>
+#include <cstdint>
+#include <limits>
 
 enum class TemplateTokenType;
 
@@ -15,10 +17,24 @@ struct TemplateFileParams
 	int yday    = 0;
     int week    = 0;
     int hour    = 0;
+    int index   = 0;
+    int thread  = 0;
 
     bool operator < (const TemplateFileParams &rhs) const;
 };
 
+/**
+ * @brief Time range of the records written to the same file, [start_ms, end_ms)
+ *  in milliseconds since epoch.
+ */
+struct RotationPeriod
+{
+    int64_t start_ms    = std::numeric_limits<int64_t>::min();
+    int64_t end_ms      = std::numeric_limits<int64_t>::max();
+
+    bool contains(int64_t time_ms) const { return time_ms >= start_ms && time_ms < end_ms; }
+};
+
 class FilenameTemplate
 {
 public:
@@ -27,11 +43,38 @@ public:
 
     bool rotatable() const { return is_rotatable; }
 
-    bool is_need_rotate(const std::tm& tm, const std::tm& current_tm) const;
+    bool has_index() const { return is_indexed; }
+
+    bool has_thread() const { return is_threaded; }
+
+    /**
+     * @brief Returns the template of the thread's files, %t is replaced with the thread number.
+     * 
+     * @param thread 
+     * @return std::string 
+     */
+    std::string bind_thread(unsigned int thread) const;
+
+    /**
+     * @brief Returns the time range of the file generated for the local datetime,
+     *  the time fields of the filename don't change within it. The boundaries are
+     *  computed with mktime, so the timezone and DST changes are taken into account.
+     * 
+     * @param tm 
+     * @return RotationPeriod 
+     */
+    RotationPeriod get_rotation_period(const std::tm& tm) const;
 
-    std::string generate_filename(const std::tm& tm) const;
+    std::string generate_filename(const std::tm& tm, unsigned int index = 0) const;
 
-    std::optional<TemplateFileParams> parse_filename(const std::string &filename);
+    /**
+     * @brief Parses the name of a file created by the template,
+     *  the name may have a compression suffix (".gz", ".zst").
+     * 
+     * @param filename 
+     * @return std::optional<TemplateFileParams> 
+     */
+    std::optional<TemplateFileParams> parse_filename(const std::string &filename) const;
 
 private:
 
@@ -47,6 +90,8 @@ private:
     };
 
     bool is_rotatable;
+    bool is_indexed;
+    bool is_threaded;
     size_t name_start_token;
     size_t name_pos;
     std::vector<TemplateToken> template_tokens;
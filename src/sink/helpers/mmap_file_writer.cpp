@@ -0,0 +1,159 @@
+#include "mmap_file_writer.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "fd_io.h"
+
+namespace logging {
+
+/**
+ * @brief Extends the file to the given size, allocating disk blocks when possible.
+ * 
+ * @param fd 
+ * @param size 
+ * @return true on success
+ */
+static bool allocate_file(int fd, off_t size)
+{
+#ifdef __linux__
+    if (::fallocate(fd, 0, 0, size) == 0) {
+        return true;
+    }
+    if (errno != EOPNOTSUPP) {
+        return false;
+    }
+#endif
+    return ::ftruncate(fd, size) == 0;
+}
+
+MmapLogFile::MmapLogFile(const std::string& filename, size_t chunk_size)
+    : LogFile(filename)
+    , mapping(nullptr)
+    , capacity(0)
+    , data_size(0)
+    , chunk_size(chunk_size)
+{
+    fd = ::open(file_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+
+    struct stat st;
+    if (fd < 0 || ::fstat(fd, &st) != 0) {
+        std::cerr 
+            << "Can't open log file: "
+            << file_path
+            << std::endl;
+        close();
+        return;
+    }
+
+    data_size = static_cast<size_t>(st.st_size);
+    if (!reserve(0)) {
+        close();
+        return;
+    }
+
+    // cut off the preallocated tail of a file that wasn't closed properly
+    while (data_size && mapping[data_size - 1] == '\0') {
+        --data_size;
+    }
+}
+
+MmapLogFile::~MmapLogFile()
+{
+    close();
+}
+
+void MmapLogFile::write(FileRecordData &data)
+{
+    if (!mapping || !reserve(data.data.length() + 1)) {
+        return;
+    }
+
+    memcpy(mapping + data_size, data.data.data(), data.data.length());
+    data_size += data.data.length();
+    mapping[data_size++] = '\n';
+}
+
+void MmapLogFile::flush()
+{ }
+
+/**
+ * @brief Ensures there is room for size bytes after the data, grows and remaps the file if needed.
+ * 
+ * @param size 
+ * @return true on success
+ */
+bool MmapLogFile::reserve(size_t size)
+{
+    if (mapping && data_size + size <= capacity) {
+        return true;
+    }
+
+    size_t new_capacity = (data_size + size + chunk_size) / chunk_size * chunk_size;
+    if (!allocate_file(fd, static_cast<off_t>(new_capacity))) {
+        std::cerr 
+            << "Can't extend log file: "
+            << file_path
+            << std::endl;
+        return false;
+    }
+
+    void *new_mapping;
+#ifdef __linux__
+    if (mapping) {
+        new_mapping = ::mremap(mapping, capacity, new_capacity, MREMAP_MAYMOVE);
+    } else {
+        new_mapping = ::mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+#else
+    if (mapping) {
+        ::munmap(mapping, capacity);
+    }
+    new_mapping = ::mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+#endif
+    if (new_mapping == MAP_FAILED) {
+        std::cerr 
+            << "Can't map log file: "
+            << file_path
+            << std::endl;
+#ifndef __linux__
+        // the old mapping was unmapped, a failed mremap keeps it valid
+        mapping = nullptr;
+        capacity = 0;
+#endif
+        return false;
+    }
+
+    mapping = static_cast<char*>(new_mapping);
+    capacity = new_capacity;
+    return true;
+}
+
+void MmapLogFile::close()
+{
+    if (mapping) {
+        ::munmap(mapping, capacity);
+        mapping = nullptr;
+    }
+    if (fd >= 0) {
+        if (::ftruncate(fd, static_cast<off_t>(data_size)) != 0) {
+            std::cerr 
+                << "Can't truncate log file: "
+                << file_path
+                << std::endl;
+        }
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+int MmapLogFile::open_sync_handle()
+{
+    flush();
+    return duplicate_fd(fd);
+}
+
+} // namespace logging
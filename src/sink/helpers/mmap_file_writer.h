@@ -0,0 +1,43 @@
+#pragma once
+
+#include "file_writer.h"
+
+namespace logging {
+
+/**
+ * @brief Log file that is written through a memory-mapped region.
+ * 
+ *  The file is extended by chunks of chunk_size bytes, records are copied
+ *  straight into the mapping. The file is truncated to the length of
+ *  written data when it is closed, a preallocated zero tail left by a crash
+ *  is cut off when the file is opened again.
+ */
+class MmapLogFile : public LogFile
+{
+public:
+
+    static constexpr size_t default_chunk_size = 4 * 1024 * 1024;
+
+    MmapLogFile(const std::string& filename, size_t chunk_size = default_chunk_size);
+
+    virtual ~MmapLogFile();
+
+    virtual void write(FileRecordData &data) override;
+
+    virtual void flush() override;
+
+    virtual int open_sync_handle() override;
+
+private:
+
+    int fd;
+    char *mapping;
+    size_t capacity;
+    size_t data_size;
+    size_t chunk_size;
+
+    bool reserve(size_t size);
+    void close();
+};
+
+} // namespace logging
@@ -0,0 +1,37 @@
+#include "periodic_timer.h"
+
+namespace logging {
+
+PeriodicTimer::~PeriodicTimer()
+{
+    stop();
+}
+
+void PeriodicTimer::start(unsigned int interval_ms, std::function<void()> task)
+{
+    stop();
+    stopping = false;
+    thread = std::thread([this, interval_ms, task = std::move(task)]() {
+        const auto interval = std::chrono::milliseconds(interval_ms);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!cv.wait_for(lock, interval, [this]() { return stopping; })) {
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    });
+}
+
+void PeriodicTimer::stop()
+{
+    if (thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        thread.join();
+    }
+}
+
+} // namespace logging
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+namespace logging {
+
+/**
+ * @brief Calls a task periodically in a background thread.
+ * 
+ */
+class PeriodicTimer
+{
+public:
+
+    PeriodicTimer() = default;
+
+    ~PeriodicTimer();
+
+    PeriodicTimer(const PeriodicTimer&) = delete;
+    PeriodicTimer& operator = (const PeriodicTimer&) = delete;
+
+    /**
+     * @brief Starts the thread, the running timer is stopped first.
+     * 
+     * @param interval_ms 
+     * @param task 
+     */
+    void start(unsigned int interval_ms, std::function<void()> task);
+
+    void stop();
+
+private:
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+};
+
+} // namespace logging
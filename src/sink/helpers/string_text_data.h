@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <logging/logging.h>
+
+namespace logging {
+
+/**
+ * @brief Text data appended to an external string buffer.
+ *  The reserved size includes extra bytes for the text appended after the record.
+ */
+struct StringTextData : public ITextData
+{
+    std::string &data;
+    size_t extra;
+
+    StringTextData(std::string &data, size_t extra = 0) : data(data), extra(extra) { }
+
+    virtual void append(const char* text) override
+    {
+        data.append(text);
+    }
+
+    virtual void reserve(unsigned long size) override
+    {
+        data.reserve(data.length() + size + extra);
+    }
+
+    virtual void append_text(const char* text, size_t length) override
+    {
+        data.append(text, length);
+    }
+
+    virtual void append_fill(char fill, size_t count) override
+    {
+        data.append(count, fill);
+    }
+};
+
+} // namespace logging
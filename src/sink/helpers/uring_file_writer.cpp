@@ -0,0 +1,430 @@
+#include "uring_file_writer.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include "fd_io.h"
+
+namespace logging {
+
+constexpr unsigned ring_entries = 8;
+constexpr unsigned num_buffers = 4;
+constexpr size_t buffer_size = 256 * 1024;
+
+static int io_uring_setup(unsigned entries, struct io_uring_params *params)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+static int io_uring_register(int ring_fd, unsigned opcode, const void *arg, unsigned nr_args)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+/**
+ * @brief io_uring instance with the registered write buffers.
+ * 
+ */
+struct UringLogFile::Ring
+{
+    enum class BufferState { FREE, FILLED, IN_FLIGHT };
+
+    struct Buffer
+    {
+        char *data = nullptr;
+        size_t size = 0;
+        BufferState state = BufferState::FREE;
+    };
+
+    int ring_fd = -1;
+    int fd = -1;
+    bool fixed_buffers = false;
+
+    void *sq_ptr = nullptr;
+    void *cq_ptr = nullptr;
+    size_t sq_ring_size = 0;
+    size_t cq_ring_size = 0;
+    struct io_uring_sqe *sqes = nullptr;
+    size_t sqes_size = 0;
+
+    unsigned *sq_tail = nullptr;
+    unsigned *sq_mask = nullptr;
+    unsigned *sq_array = nullptr;
+    unsigned *cq_head = nullptr;
+    unsigned *cq_tail = nullptr;
+    unsigned *cq_mask = nullptr;
+    struct io_uring_cqe *cqes = nullptr;
+
+    Buffer buffers[num_buffers];
+    unsigned current = 0;                   // buffer that receives records
+    std::vector<unsigned> filled;           // filled buffers in the order of records
+    unsigned in_flight = 0;
+    bool broken = false;                    // io_uring failed, the data is written synchronously
+
+    ~Ring()
+    {
+        // the ring is closed first, so the kernel doesn't use the buffers after they are freed
+        if (ring_fd >= 0) {
+            ::close(ring_fd);
+        }
+        if (sqes) {
+            ::munmap(sqes, sqes_size);
+        }
+        if (cq_ptr && cq_ptr != sq_ptr) {
+            ::munmap(cq_ptr, cq_ring_size);
+        }
+        if (sq_ptr) {
+            ::munmap(sq_ptr, sq_ring_size);
+        }
+        for (auto &buffer : buffers) {
+            free(buffer.data);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    bool init()
+    {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ring_fd = io_uring_setup(ring_entries, &params);
+        if (ring_fd < 0) {
+            return false;
+        }
+
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) {
+            sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+        }
+
+        sq_ptr = ::mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        if (sq_ptr == MAP_FAILED) {
+            sq_ptr = nullptr;
+            return false;
+        }
+        if (single_mmap) {
+            cq_ptr = sq_ptr;
+        } else {
+            cq_ptr = ::mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+            if (cq_ptr == MAP_FAILED) {
+                cq_ptr = nullptr;
+                return false;
+            }
+        }
+        sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+        void *sqes_ptr = ::mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+        if (sqes_ptr == MAP_FAILED) {
+            return false;
+        }
+        sqes = static_cast<struct io_uring_sqe*>(sqes_ptr);
+
+        char *sq = static_cast<char*>(sq_ptr);
+        char *cq = static_cast<char*>(cq_ptr);
+        sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        struct iovec iov[num_buffers];
+        for (unsigned i = 0; i < num_buffers; ++i) {
+            buffers[i].data = static_cast<char*>(aligned_alloc(4096, buffer_size));
+            if (!buffers[i].data) {
+                return false;
+            }
+            iov[i].iov_base = buffers[i].data;
+            iov[i].iov_len = buffer_size;
+        }
+        // registration may fail because of RLIMIT_MEMLOCK, plain writes are used then
+        fixed_buffers = io_uring_register(ring_fd, IORING_REGISTER_BUFFERS, iov, num_buffers) == 0;
+
+        return true;
+    }
+
+    /**
+     * @brief Submits the filled buffers as a chain of linked writes. Only one chain is in flight:
+     *  the previous one is waited for first, so the rest of its short write is written
+     *  before any later data. If the submission fails, the ring is marked broken and
+     *  the buffers that weren't submitted are written synchronously after the submitted ones.
+     * 
+     */
+    void submit()
+    {
+        if (filled.empty()) {
+            return;
+        }
+        drain();
+        if (broken) {
+            write_filled();
+            return;
+        }
+
+        unsigned tail = *sq_tail;
+        for (size_t i = 0; i < filled.size(); ++i) {
+            unsigned index = tail & *sq_mask;
+            struct io_uring_sqe *sqe = &sqes[index];
+            Buffer &buffer = buffers[filled[i]];
+
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = fixed_buffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+            sqe->fd = fd;
+            sqe->addr = reinterpret_cast<uint64_t>(buffer.data);
+            sqe->len = static_cast<uint32_t>(buffer.size);
+            sqe->off = 0;   // the file is opened with O_APPEND
+            sqe->buf_index = static_cast<uint16_t>(filled[i]);
+            sqe->user_data = filled[i];
+            if (i + 1 < filled.size()) {
+                sqe->flags |= IOSQE_IO_LINK;
+            }
+            sq_array[index] = index;
+            buffer.state = BufferState::IN_FLIGHT;
+            ++tail;
+        }
+        __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+
+        unsigned count = static_cast<unsigned>(filled.size());
+        in_flight += count;
+
+        unsigned submitted = 0;
+        int error = 0;
+        while (submitted < count) {
+            int res = io_uring_enter(ring_fd, count - submitted, 0, 0);
+            if (res > 0) {
+                submitted += static_cast<unsigned>(res);
+            } else if (res == 0 || errno != EINTR) {
+                error = res < 0 ? errno : EAGAIN;
+                break;
+            }
+        }
+
+        if (submitted == count) {
+            filled.clear();
+            return;
+        }
+
+        std::cerr << "io_uring submission failed, errno: " << error << std::endl;
+        broken = true;
+        // the kernel reads the queue only in io_uring_enter, so the entries are taken back
+        __atomic_store_n(sq_tail, tail - (count - submitted), __ATOMIC_RELEASE);
+        in_flight -= count - submitted;
+        filled.erase(filled.begin(), filled.begin() + submitted);
+        for (unsigned index : filled) {
+            buffers[index].state = BufferState::FILLED;
+        }
+        drain();
+        write_filled();
+    }
+
+    /**
+     * @brief Waits for the submitted writes, marks the ring broken if waiting fails.
+     * 
+     */
+    void drain()
+    {
+        while (in_flight) {
+            if (!reap(1)) {
+                broken = true;
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Writes the filled buffers synchronously.
+     * 
+     */
+    void write_filled()
+    {
+        for (unsigned index : filled) {
+            Buffer &buffer = buffers[index];
+            if (!write_all(fd, buffer.data, buffer.size)) {
+                std::cerr << "Can't write log file, errno: " << errno << std::endl;
+            }
+            buffer.size = 0;
+            buffer.state = BufferState::FREE;
+        }
+        filled.clear();
+    }
+
+    /**
+     * @brief Handles the completed writes.
+     * 
+     * @param min_complete  number of completions to wait for
+     * @return false if waiting failed
+     */
+    bool reap(unsigned min_complete)
+    {
+        bool result = true;
+        if (min_complete) {
+            int res;
+            while ((res = io_uring_enter(ring_fd, 0, min_complete, IORING_ENTER_GETEVENTS)) < 0 && errno == EINTR);
+            if (res < 0) {
+                std::cerr << "io_uring wait failed, errno: " << errno << std::endl;
+                result = false;
+            }
+        }
+
+        unsigned head = *cq_head;
+        unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            struct io_uring_cqe *cqe = &cqes[head & *cq_mask];
+            complete(static_cast<unsigned>(cqe->user_data), cqe->res);
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        return result;
+    }
+
+    void complete(unsigned index, int res)
+    {
+        Buffer &buffer = buffers[index];
+        size_t written = res > 0 ? static_cast<size_t>(res) : 0;
+
+        // a short write fails the rest of the chain with ECANCELED, the remainder
+        // and the canceled buffers are written synchronously in the order of completions
+        if (written < buffer.size && (res >= 0 || res == -ECANCELED)) {
+            if (!write_all(fd, buffer.data + written, buffer.size - written)) {
+                std::cerr << "Can't write log file, errno: " << errno << std::endl;
+            }
+        } else if (res < 0) {
+            std::cerr << "Can't write log file, error: " << -res << std::endl;
+        }
+
+        buffer.size = 0;
+        buffer.state = BufferState::FREE;
+        --in_flight;
+    }
+
+    /**
+     * @brief Switches to the next free buffer, waits for a completion if all buffers are busy.
+     *  A broken ring writes the filled buffers synchronously.
+     * 
+     */
+    void next_buffer()
+    {
+        filled.push_back(current);
+        buffers[current].state = BufferState::FILLED;
+
+        reap(0);
+        while (!broken) {
+            for (unsigned i = 0; i < num_buffers; ++i) {
+                if (buffers[i].state == BufferState::FREE) {
+                    current = i;
+                    return;
+                }
+            }
+            submit();
+            if (!broken && !reap(1)) {
+                broken = true;
+            }
+        }
+        write_filled();
+    }
+
+    /**
+     * @brief Submits the filled buffers and waits for all writes,
+     *  stops waiting if the ring fails.
+     * 
+     */
+    void wait_all()
+    {
+        submit();
+        drain();
+    }
+};
+
+std::unique_ptr<LogFile> UringLogFile::create(const std::string& filename)
+{
+    auto ring = std::make_unique<Ring>();
+    if (!ring->init()) {
+        return nullptr;
+    }
+
+    std::unique_ptr<UringLogFile> file{new UringLogFile(filename, std::move(ring))};
+    if (file->ring->fd < 0) {
+        std::cerr 
+            << "Can't open log file: "
+            << file->file_path
+            << std::endl;
+    }
+    return file;
+}
+
+UringLogFile::UringLogFile(const std::string& filename, std::unique_ptr<Ring> ring)
+    : LogFile(filename)
+    , ring(std::move(ring))
+{
+    this->ring->fd = ::open(file_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+}
+
+UringLogFile::~UringLogFile()
+{
+    flush();
+    ring->wait_all();
+}
+
+void UringLogFile::write(FileRecordData &data)
+{
+    if (ring->fd < 0) {
+        return;
+    }
+
+    size_t size = data.data.length() + 1;
+    if (size > buffer_size) {
+        // a huge record is written directly after the buffered ones
+        flush();
+        ring->wait_all();
+        struct iovec iov[] = {
+            {const_cast<char*>(data.data.data()), data.data.length()},
+            {const_cast<char*>("\n"), 1},
+        };
+        writev_all(ring->fd, iov, 2);
+        return;
+    }
+
+    if (ring->buffers[ring->current].size + size > buffer_size) {
+        ring->next_buffer();
+    }
+
+    auto &buffer = ring->buffers[ring->current];
+    memcpy(buffer.data + buffer.size, data.data.data(), data.data.length());
+    buffer.data[buffer.size + data.data.length()] = '\n';
+    buffer.size += size;
+    buffered += size;
+}
+
+void UringLogFile::flush()
+{
+    ring->reap(0);
+    if (ring->buffers[ring->current].size) {
+        ring->next_buffer();
+    }
+    ring->submit();
+    buffered = 0;
+}
+
+int UringLogFile::open_sync_handle()
+{
+    flush();
+    ring->wait_all();
+    return duplicate_fd(ring->fd);
+}
+
+} // namespace logging
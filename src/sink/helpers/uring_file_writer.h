@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include "file_writer.h"
+
+namespace logging {
+
+/**
+ * @brief Log file that is written asynchronously through io_uring.
+ * 
+ *  Records are copied into a small set of registered buffers. On flush the filled
+ *  buffers are submitted as a chain of linked writes. Only one chain is in flight:
+ *  a flush waits for the previous chain, so the rest of a short write is appended
+ *  before any later data. The writer doesn't wait for its own submission, records
+ *  written meanwhile are collected in the next buffer.
+ *
+ *  A flush submits the current buffer however small it is, so with FlushPolicy::buffer_size = 0
+ *  every record is a separate write. A larger buffer_size batches small records,
+ *  e.g. 64 KiB takes a quarter of a buffer per write.
+ */
+class UringLogFile : public LogFile
+{
+public:
+
+    /**
+     * @brief Creates a log file, returns nullptr if io_uring isn't available.
+     * 
+     * @param filename 
+     * @return std::unique_ptr<LogFile> 
+     */
+    static std::unique_ptr<LogFile> create(const std::string& filename);
+
+    virtual ~UringLogFile();
+
+    virtual void write(FileRecordData &data) override;
+
+    virtual void flush() override;
+
+    virtual int open_sync_handle() override;
+
+private:
+
+    struct Ring;
+
+    UringLogFile(const std::string& filename, std::unique_ptr<Ring> ring);
+
+    std::unique_ptr<Ring> ring;
+};
+
+} // namespace logging
@@ -0,0 +1,82 @@
+#include <logging/sink/ring.h>
+#include <memory>
+#include <cstring>
+#include "helpers/byte_ring.h"
+#include "helpers/string_text_data.h"
+
+namespace logging {
+
+/*
+ *
+ *  RingSink::Impl class
+ *
+ */
+
+class RingSink::Impl
+{
+public:
+
+    std::unique_ptr<uint64_t[]> region;
+    ByteRing ring;
+
+    Impl(size_t capacity)
+        : region{new uint64_t[ByteRing::region_size(capacity) / 8]}
+        , ring{region.get(), capacity}
+    { }
+};
+
+/*
+ *
+ *  RingSink class
+ *
+ */
+
+RingSink::RingSink(size_t capacity)
+    : pimpl(std::make_unique<Impl>(capacity))
+{ }
+
+RingSink::~RingSink() = default;
+
+std::vector<RingRecord> RingSink::snapshot(const RingQuery &query) const
+{
+    std::vector<RingRecord> records;
+    pimpl->ring.read(0, [&records, &query](RingRecord &&record) {
+        if (record.level >= query.min_level && record.time >= query.from_ms && record.time <= query.to_ms) {
+            records.push_back(std::move(record));
+        }
+    });
+
+    if (query.max_records && records.size() > query.max_records) {
+        records.erase(records.begin(), records.end() - query.max_records);
+    }
+    return records;
+}
+
+size_t RingSink::capacity() const
+{
+    return pimpl->ring.capacity();
+}
+
+uint64_t RingSink::written_bytes() const
+{
+    return pimpl->ring.header()->head.load(std::memory_order_relaxed);
+}
+
+void RingSink::write(ILogRecordData *record, IFormatter *logger_formatter)
+{
+    IFormatter *formatter = sink_formatter ? static_cast<IFormatter*>(sink_formatter.get()) : logger_formatter;
+    if (!formatter) {
+        const char *text = record->get_data();
+        pimpl->ring.push(record->get_time(), record->get_level(), text, strlen(text));
+        return;
+    }
+
+    // the buffer keeps its capacity between records of the thread
+    thread_local std::string text;
+    text.clear();
+    StringTextData data{text};
+    formatter->format_record(&data, record);
+    pimpl->ring.push(record->get_time(), record->get_level(), text.data(), text.length());
+}
+
+} // namespace logging
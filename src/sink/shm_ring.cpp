@@ -0,0 +1,280 @@
+#include <logging/sink/shm_ring.h>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include "helpers/byte_ring.h"
+#include "helpers/string_text_data.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace logging {
+
+constexpr auto attach_timeout = std::chrono::seconds(1);
+constexpr auto pending_timeout = std::chrono::seconds(1);
+
+/**
+ * @brief Shared memory mapping of a ring.
+ * 
+ */
+struct ShmRegion
+{
+    void *region = nullptr;
+    size_t size = 0;
+    std::unique_ptr<ByteRing> ring;
+
+    ~ShmRegion()
+    {
+        ring.reset();
+        if (region) {
+            munmap(region, size);
+        }
+    }
+
+    bool map(int fd, size_t region_size)
+    {
+        void *res = mmap(nullptr, region_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (res == MAP_FAILED) {
+            return false;
+        }
+        region = res;
+        size = region_size;
+        return true;
+    }
+};
+
+/**
+ * @brief Waits for another process to finish the initialization of the ring.
+ * 
+ * @param fd 
+ * @param min_size 
+ * @return size_t size of the shared memory object, 0 on timeout
+ */
+static size_t wait_object_size(int fd, size_t min_size)
+{
+    auto deadline = std::chrono::steady_clock::now() + attach_timeout;
+    struct stat st;
+    while (fstat(fd, &st) == 0) {
+        if (static_cast<size_t>(st.st_size) >= min_size) {
+            return static_cast<size_t>(st.st_size);
+        }
+        if (std::chrono::steady_clock::now() > deadline) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return 0;
+}
+
+static bool wait_valid(const ByteRing &ring)
+{
+    auto deadline = std::chrono::steady_clock::now() + attach_timeout;
+    while (!ring.valid()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+/*
+ *
+ *  ShmRingSink::Impl class
+ *
+ */
+
+class ShmRingSink::Impl
+{
+public:
+
+    ShmRegion shm;
+
+    Impl(const std::string &name, size_t capacity);
+};
+
+ShmRingSink::Impl::Impl(const std::string &name, size_t capacity)
+{
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    bool created = fd >= 0;
+    if (!created && errno == EEXIST) {
+        fd = shm_open(name.c_str(), O_RDWR, 0);
+    }
+    if (fd < 0) {
+        std::cerr 
+            << "Can't open shared memory ring: "
+            << name
+            << std::endl;
+        return;
+    }
+
+    size_t size = ByteRing::region_size(capacity);
+    if (created) {
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            size = 0;
+        }
+    } else {
+        // the ring of another process keeps its capacity
+        size = wait_object_size(fd, sizeof(ByteRingHeader) + 8);
+    }
+
+    if (size && shm.map(fd, size)) {
+        shm.ring = std::make_unique<ByteRing>(shm.region, size - sizeof(ByteRingHeader), created);
+        if (!wait_valid(*shm.ring)) {
+            shm.ring.reset();
+        }
+    }
+    ::close(fd);
+
+    if (!shm.ring) {
+        std::cerr 
+            << "Can't map shared memory ring: "
+            << name
+            << std::endl;
+    }
+}
+
+/*
+ *
+ *  ShmRingSink class
+ *
+ */
+
+ShmRingSink::ShmRingSink(const std::string &name, size_t capacity)
+    : pimpl(std::make_unique<Impl>(name, capacity))
+{ }
+
+ShmRingSink::~ShmRingSink() = default;
+
+bool ShmRingSink::is_open() const
+{
+    return pimpl->shm.ring != nullptr;
+}
+
+uint64_t ShmRingSink::get_lost_bytes() const
+{
+    return pimpl->shm.ring ? pimpl->shm.ring->header()->lost_bytes.load(std::memory_order_relaxed) : 0;
+}
+
+void ShmRingSink::write(ILogRecordData *record, IFormatter *logger_formatter)
+{
+    auto &ring = pimpl->shm.ring;
+    if (!ring) {
+        return;
+    }
+
+    IFormatter *formatter = sink_formatter ? static_cast<IFormatter*>(sink_formatter.get()) : logger_formatter;
+    if (!formatter) {
+        const char *text = record->get_data();
+        ring->push(record->get_time(), record->get_level(), text, strlen(text));
+        return;
+    }
+
+    // the buffer keeps its capacity between records of the thread
+    thread_local std::string text;
+    text.clear();
+    StringTextData data{text};
+    formatter->format_record(&data, record);
+    ring->push(record->get_time(), record->get_level(), text.data(), text.length());
+}
+
+/*
+ *
+ *  ShmRingReader::Impl class
+ *
+ */
+
+class ShmRingReader::Impl
+{
+public:
+
+    ShmRegion shm;
+    uint64_t stalled_pos;
+    std::chrono::steady_clock::time_point stalled_since;
+
+    Impl(const std::string &name);
+};
+
+ShmRingReader::Impl::Impl(const std::string &name)
+    : stalled_pos{0}
+{
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        return;
+    }
+    size_t size = wait_object_size(fd, sizeof(ByteRingHeader) + 8);
+    if (size && shm.map(fd, size)) {
+        shm.ring = std::make_unique<ByteRing>(shm.region, size - sizeof(ByteRingHeader), false);
+        if (!wait_valid(*shm.ring)) {
+            shm.ring.reset();
+        }
+    }
+    ::close(fd);
+}
+
+/*
+ *
+ *  ShmRingReader class
+ *
+ */
+
+ShmRingReader::ShmRingReader(const std::string &name)
+    : pimpl(std::make_unique<Impl>(name))
+{ }
+
+ShmRingReader::~ShmRingReader() = default;
+
+bool ShmRingReader::is_open() const
+{
+    return pimpl->shm.ring != nullptr;
+}
+
+size_t ShmRingReader::read(std::vector<RingRecord> &records)
+{
+    auto &ring = pimpl->shm.ring;
+    if (!ring) {
+        return 0;
+    }
+
+    auto header = ring->header();
+    size_t count = records.size();
+    uint64_t lost = 0;
+    uint64_t from = header->read_pos.load(std::memory_order_relaxed);
+    uint64_t pos = ring->read(from, [&records](RingRecord &&record) {
+        records.push_back(std::move(record));
+    }, &lost, true);
+
+    if (pos < header->head.load(std::memory_order_acquire)) {
+        // the record at pos isn't committed, its writer may be gone
+        auto now = std::chrono::steady_clock::now();
+        if (pos != pimpl->stalled_pos) {
+            pimpl->stalled_pos = pos;
+            pimpl->stalled_since = now;
+        } else if (now - pimpl->stalled_since > pending_timeout) {
+            uint64_t next = ring->skip(pos);
+            lost += next - pos;
+            pos = next;
+        }
+    }
+
+    if (lost) {
+        header->lost_bytes.fetch_add(lost, std::memory_order_relaxed);
+    }
+    header->read_pos.store(pos, std::memory_order_relaxed);
+    return records.size() - count;
+}
+
+uint64_t ShmRingReader::get_lost_bytes() const
+{
+    return pimpl->shm.ring ? pimpl->shm.ring->header()->lost_bytes.load(std::memory_order_relaxed) : 0;
+}
+
+bool ShmRingReader::remove(const std::string &name)
+{
+    return shm_unlink(name.c_str()) == 0;
+}
+
+} // namespace logging
@@ -0,0 +1,348 @@
+#include <logging/sink/syslog.h>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <logging/log_level.h>
+#include <logging/helper/datetime.h>
+#include "helpers/periodic_timer.h"
+#include "helpers/string_text_data.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/uio.h>
+
+namespace logging {
+
+constexpr size_t default_batch_size = 64 * 1024;
+constexpr unsigned int default_batch_interval_ms = 100;
+constexpr size_t max_batch_messages = 256;
+
+static const char* default_socket_path(SyslogProtocol protocol)
+{
+    return protocol == SyslogProtocol::JOURNALD ? "/run/systemd/journal/socket" : "/dev/log";
+}
+
+static std::string default_app_name()
+{
+#ifdef __GLIBC__
+    return program_invocation_short_name;
+#else
+    return "logging";
+#endif
+}
+
+/**
+ * @brief Maps the log level to the syslog severity.
+ * 
+ * @param level 
+ * @return int 
+ */
+static int syslog_severity(LogLevel level)
+{
+    switch (level) {
+        case LogLevel::DEBUG:   return 7;
+        case LogLevel::INFO:    return 6;
+        case LogLevel::WARNING: return 4;
+        case LogLevel::ERROR:   return 3;
+        case LogLevel::FATAL:   return 2;
+        default:                return 5;
+    }
+}
+
+/*
+ *
+ *  SyslogSink::Impl class
+ *
+ */
+
+class SyslogSink::Impl
+{
+public:
+
+    SyslogProtocol protocol;
+    std::string app_name;
+    std::string socket_path;
+    std::string host_name;
+    std::string process_id;
+    std::atomic<int> facility;
+    std::atomic<uint64_t> dropped;
+
+    std::mutex mutex;
+    int fd;
+    FlushPolicy flush_policy;
+    std::vector<std::string> messages;
+    size_t batch_size;
+    PeriodicTimer flush_timer;
+
+    Impl(SyslogProtocol protocol, const std::string &app_name, const std::string &socket_path);
+    ~Impl();
+    void format_message(std::string &message, ILogRecordData *record, const std::string &text) const;
+    void add_message(std::string &&message, LogLevel level);
+    void set_flush_policy(const FlushPolicy &policy);
+    void flush();
+    void send_messages();
+    bool connect();
+};
+
+SyslogSink::Impl::Impl(SyslogProtocol protocol, const std::string &app_name, const std::string &socket_path)
+    : protocol{protocol}
+    , app_name{app_name.empty() ? default_app_name() : app_name}
+    , socket_path{socket_path.empty() ? default_socket_path(protocol) : socket_path}
+    , process_id{std::to_string(getpid())}
+    , facility{1}
+    , dropped{0}
+    , fd{-1}
+    , batch_size{0}
+{
+    char name[256] = {0};
+    if (gethostname(name, sizeof(name) - 1) == 0) {
+        host_name = name;
+    }
+    set_flush_policy({default_batch_size, default_batch_interval_ms, LogLevel::ERROR});
+}
+
+SyslogSink::Impl::~Impl()
+{
+    flush_timer.stop();
+    flush();
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+/**
+ * @brief Connects the socket, the daemon may be started after the sink.
+ * 
+ * @return true if the socket is connected
+ */
+bool SyslogSink::Impl::connect()
+{
+    if (fd >= 0) {
+        return true;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.length() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    memcpy(addr.sun_path, socket_path.c_str(), socket_path.length());
+
+#ifdef SOCK_NONBLOCK
+    fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+#else
+    fd = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (fd >= 0) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+    if (fd < 0) {
+        return false;
+    }
+    if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Builds the datagram of the record.
+ * 
+ * @param message   the result
+ * @param record 
+ * @param text      formatted text of the record
+ */
+void SyslogSink::Impl::format_message(std::string &message, ILogRecordData *record, const std::string &text) const
+{
+    int severity = syslog_severity(record->get_level());
+
+    if (protocol == SyslogProtocol::JOURNALD) {
+        message.append("PRIORITY=").append(std::to_string(severity)).append(1, '\n');
+        message.append("SYSLOG_FACILITY=").append(std::to_string(facility)).append(1, '\n');
+        message.append("SYSLOG_IDENTIFIER=").append(app_name).append(1, '\n');
+        if (*record->get_file_name()) {
+            message.append("CODE_FILE=").append(record->get_file_name()).append(1, '\n');
+            message.append("CODE_LINE=").append(std::to_string(record->get_line_number())).append(1, '\n');
+        }
+        if (text.find('\n') == std::string::npos) {
+            message.append("MESSAGE=").append(text).append(1, '\n');
+        } else {
+            // a multiline value is sent with its 64-bit little-endian length
+            message.append("MESSAGE\n");
+            uint64_t length = text.length();
+            for (int i = 0; i < 8; ++i) {
+                message.append(1, static_cast<char>((length >> (i * 8)) & 0xff));
+            }
+            message.append(text).append(1, '\n');
+        }
+        return;
+    }
+
+    // <PRI>1 TIMESTAMP HOSTNAME APP-NAME PROCID MSGID STRUCTURED-DATA MSG
+    int64_t ms = record->get_time();
+    std::tm tm;
+    utc_datetime(&tm, static_cast<time_t>(ms / 1000));
+    char timestamp[32];
+    size_t length = std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", &tm);
+    snprintf(timestamp + length, sizeof(timestamp) - length, ".%03dZ", static_cast<int>(ms % 1000));
+
+    message.append(1, '<').append(std::to_string(facility * 8 + severity)).append(">1 ");
+    message.append(timestamp).append(1, ' ');
+    message.append(host_name.empty() ? "-" : host_name).append(1, ' ');
+    message.append(app_name).append(1, ' ');
+    message.append(process_id).append(" - - ");
+    message.append(text);
+}
+
+void SyslogSink::Impl::set_flush_policy(const FlushPolicy &policy)
+{
+    flush_timer.stop();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        flush_policy = policy;
+        if (batch_size >= flush_policy.buffer_size) {
+            send_messages();
+        }
+    }
+    if (flush_policy.interval_ms) {
+        flush_timer.start(flush_policy.interval_ms, [this]() { flush(); });
+    }
+}
+
+void SyslogSink::Impl::flush()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    send_messages();
+}
+
+void SyslogSink::Impl::add_message(std::string &&message, LogLevel level)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    batch_size += message.length();
+    messages.push_back(std::move(message));
+    if (batch_size >= flush_policy.buffer_size || level >= flush_policy.flush_level) {
+        send_messages();
+    }
+}
+
+/**
+ * @brief Sends the batch, messages that can't be sent without blocking are dropped.
+ * 
+ */
+void SyslogSink::Impl::send_messages()
+{
+    if (messages.empty()) {
+        return;
+    }
+
+    size_t sent = 0;
+    if (connect()) {
+#ifdef __linux__
+        std::vector<struct iovec> iov(std::min(messages.size(), max_batch_messages));
+        std::vector<struct mmsghdr> headers(iov.size());
+        while (sent < messages.size()) {
+            size_t count = std::min(messages.size() - sent, max_batch_messages);
+            for (size_t i = 0; i < count; ++i) {
+                auto &message = messages[sent + i];
+                iov[i] = {const_cast<char*>(message.data()), message.length()};
+                memset(&headers[i], 0, sizeof(headers[i]));
+                headers[i].msg_hdr.msg_iov = &iov[i];
+                headers[i].msg_hdr.msg_iovlen = 1;
+            }
+            int res = sendmmsg(fd, headers.data(), static_cast<unsigned int>(count), MSG_NOSIGNAL);
+            if (res < 0 && errno == EINTR) {
+                continue;
+            }
+            if (res < 0 && errno == EMSGSIZE) {
+                // the first message is too large, it's dropped
+                ++sent;
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (res <= 0) {
+                break;
+            }
+            sent += res;
+        }
+#else
+        for (; sent < messages.size(); ++sent) {
+            auto &message = messages[sent];
+            if (::send(fd, message.data(), message.length(), 0) < 0) {
+                break;
+            }
+        }
+#endif
+        if (sent < messages.size() && errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+            // the daemon has gone, reconnect with the next batch
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    dropped.fetch_add(messages.size() - sent, std::memory_order_relaxed);
+    messages.clear();
+    batch_size = 0;
+}
+
+/*
+ *
+ *  SyslogSink class
+ *
+ */
+
+SyslogSink::SyslogSink(SyslogProtocol protocol, const std::string &app_name, const std::string &socket_path)
+    : pimpl(std::make_unique<Impl>(protocol, app_name, socket_path))
+{ }
+
+SyslogSink::~SyslogSink() = default;
+
+void SyslogSink::set_facility(int facility)
+{
+    pimpl->facility = facility;
+}
+
+void SyslogSink::set_flush_policy(const FlushPolicy &policy)
+{
+    pimpl->set_flush_policy(policy);
+}
+
+void SyslogSink::flush()
+{
+    pimpl->flush();
+}
+
+uint64_t SyslogSink::get_dropped_count() const
+{
+    return pimpl->dropped.load(std::memory_order_relaxed);
+}
+
+void SyslogSink::write(ILogRecordData *record, IFormatter *logger_formatter)
+{
+    // the buffer keeps its capacity between records of the thread
+    thread_local std::string text;
+    text.clear();
+
+    IFormatter *formatter = sink_formatter ? static_cast<IFormatter*>(sink_formatter.get()) : logger_formatter;
+    if (formatter) {
+        StringTextData data{text};
+        formatter->format_record(&data, record);
+    } else {
+        text.append(record->get_data());
+    }
+
+    std::string message;
+    message.reserve(text.length() + 128);
+    pimpl->format_message(message, record, text);
+    pimpl->add_message(std::move(message), record->get_level());
+}
+
+} // namespace logging
@@ -0,0 +1,485 @@
+#include <logging/sink/tcp.h>
+#include <mutex>
+#include <deque>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <climits>
+#include <algorithm>
+#include <condition_variable>
+#include "helpers/string_text_data.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+namespace logging {
+
+constexpr size_t default_buffer_limit = 8 * 1024 * 1024;
+constexpr size_t max_write_size = 256 * 1024;
+constexpr size_t length_prefix_size = 4;
+#ifdef IOV_MAX
+constexpr size_t max_batch_records = IOV_MAX;
+#else
+constexpr size_t max_batch_records = 1024;
+#endif
+constexpr unsigned int default_reconnect_min_ms = 100;
+constexpr unsigned int default_reconnect_max_ms = 10000;
+constexpr unsigned int linger_ms = 1000;
+
+static void set_nonblocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+/*
+ *
+ *  TcpSink::Impl class
+ *
+ */
+
+class TcpSink::Impl
+{
+public:
+
+    std::string host;
+    uint16_t port;
+    TcpFraming framing;
+
+    std::mutex mutex;
+    std::condition_variable flushed_cv;
+    std::deque<std::string> records;
+    size_t buffered_bytes;
+    size_t buffer_limit;
+    DropPolicy drop_policy;
+    unsigned int reconnect_min_ms;
+    unsigned int reconnect_max_ms;
+    bool connected;
+    bool sending;
+    bool stopping;
+    std::atomic<uint64_t> dropped;
+
+    int wake_fds[2];
+    std::atomic<bool> wake_pending;
+    std::thread thread;
+
+    Impl(const std::string &host, uint16_t port, TcpFraming framing);
+    ~Impl();
+    void add_record(std::string &&record);
+    bool flush(unsigned int timeout_ms);
+    void wake();
+    void run();
+    int open_connection();
+    int wait_event(int fd, short events, int timeout_ms);
+    bool wait_reconnect(unsigned int delay_ms);
+    bool take_batch(std::vector<std::string> &batch, size_t &length);
+    void set_connected(bool value);
+};
+
+TcpSink::Impl::Impl(const std::string &host, uint16_t port, TcpFraming framing)
+    : host{host}
+    , port{port}
+    , framing{framing}
+    , buffered_bytes{0}
+    , buffer_limit{default_buffer_limit}
+    , drop_policy{DropPolicy::DROP_NEWEST}
+    , reconnect_min_ms{default_reconnect_min_ms}
+    , reconnect_max_ms{default_reconnect_max_ms}
+    , connected{false}
+    , sending{false}
+    , stopping{false}
+    , dropped{0}
+    , wake_pending{false}
+{
+    if (pipe(wake_fds) == 0) {
+        set_nonblocking(wake_fds[0]);
+        set_nonblocking(wake_fds[1]);
+    } else {
+        wake_fds[0] = wake_fds[1] = -1;
+    }
+    thread = std::thread(&Impl::run, this);
+}
+
+TcpSink::Impl::~Impl()
+{
+    bool was_connected;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        was_connected = connected;
+    }
+    if (was_connected) {
+        flush(linger_ms);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        dropped.fetch_add(records.size(), std::memory_order_relaxed);
+    }
+    wake_pending = false;
+    wake();
+    thread.join();
+    ::close(wake_fds[0]);
+    ::close(wake_fds[1]);
+}
+
+/**
+ * @brief Wakes up the sink thread, a byte is written only if the thread isn't woken yet.
+ * 
+ */
+void TcpSink::Impl::wake()
+{
+    if (!wake_pending.exchange(true)) {
+        char byte = 0;
+        ssize_t res = ::write(wake_fds[1], &byte, 1);
+        (void)res;
+    }
+}
+
+/**
+ * @brief Frames the record in place and queues it, a record with the length prefix
+ *  starts with length_prefix_size bytes reserved for it.
+ * 
+ * @param record 
+ */
+void TcpSink::Impl::add_record(std::string &&record)
+{
+    if (framing == TcpFraming::LENGTH_PREFIX) {
+        uint32_t length = static_cast<uint32_t>(record.length() - length_prefix_size);
+        for (size_t i = 0; i < length_prefix_size; ++i) {
+            record[i] = static_cast<char>((length >> ((length_prefix_size - 1 - i) * 8)) & 0xff);
+        }
+    } else {
+        record.append(1, '\n');
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (buffered_bytes + record.length() > buffer_limit) {
+            if (drop_policy == DropPolicy::DROP_NEWEST || record.length() > buffer_limit) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            while (buffered_bytes + record.length() > buffer_limit) {
+                buffered_bytes -= records.front().length();
+                records.pop_front();
+                dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        buffered_bytes += record.length();
+        records.push_back(std::move(record));
+    }
+    wake();
+}
+
+bool TcpSink::Impl::flush(unsigned int timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    flushed_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]() {
+        return records.empty() && !sending;
+    });
+    return records.empty() && !sending;
+}
+
+void TcpSink::Impl::set_connected(bool value)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    connected = value;
+    if (!connected) {
+        flushed_cv.notify_all();
+    }
+}
+
+/**
+ * @brief Moves queued records into the batch up to max_write_size bytes,
+ *  the batch is sent by a single sendmsg call without copying the records.
+ * 
+ * @param batch 
+ * @param length    total length of the batch
+ * @return false if the thread is stopping
+ */
+bool TcpSink::Impl::take_batch(std::vector<std::string> &batch, size_t &length)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    while (!records.empty() && batch.size() < max_batch_records
+        && (batch.empty() || length + records.front().length() <= max_write_size))
+    {
+        length += records.front().length();
+        buffered_bytes -= records.front().length();
+        batch.push_back(std::move(records.front()));
+        records.pop_front();
+    }
+    sending = !batch.empty();
+    if (!sending) {
+        flushed_cv.notify_all();
+    }
+    return !stopping;
+}
+
+/**
+ * @brief Waits for the socket events or for the wake up.
+ * 
+ * @param fd            socket, -1 to wait for the wake up only
+ * @param events 
+ * @param timeout_ms 
+ * @return int          returned events of the socket
+ */
+int TcpSink::Impl::wait_event(int fd, short events, int timeout_ms)
+{
+    struct pollfd fds[2] = {
+        {wake_fds[0], POLLIN, 0},
+        {fd, events, 0},
+    };
+    int res = poll(fds, fd < 0 ? 1 : 2, timeout_ms);
+    if (res > 0 && (fds[0].revents & POLLIN)) {
+        char buffer[64];
+        while (::read(wake_fds[0], buffer, sizeof(buffer)) > 0) { }
+        wake_pending = false;
+    }
+    return res > 0 && fd >= 0 ? fds[1].revents : 0;
+}
+
+/**
+ * @brief Waits for the reconnection delay, new records don't interrupt it.
+ * 
+ * @param delay_ms 
+ * @return false if the thread is stopping
+ */
+bool TcpSink::Impl::wait_reconnect(unsigned int delay_ms)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(delay_ms);
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) {
+                return false;
+            }
+        }
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            return true;
+        }
+        wait_event(-1, 0, static_cast<int>(remaining));
+    }
+}
+
+/**
+ * @brief Connects to the collector, the connection is non-blocking.
+ * 
+ * @return int  socket, -1 on failure
+ */
+int TcpSink::Impl::open_connection()
+{
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *addresses = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) {
+        return -1;
+    }
+
+    int fd = -1;
+    for (auto *addr = addresses; addr && fd < 0; addr = addr->ai_next) {
+        fd = ::socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        set_nonblocking(fd);
+        int res = ::connect(fd, addr->ai_addr, addr->ai_addrlen);
+        if (res != 0 && errno == EINPROGRESS) {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(reconnect_max_ms);
+            while (!(wait_event(fd, POLLOUT, 100) & (POLLOUT | POLLERR | POLLHUP))) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (stopping || std::chrono::steady_clock::now() > deadline) {
+                    error = ETIMEDOUT;
+                    break;
+                }
+            }
+            if (!error && getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0) {
+                error = errno;
+            }
+            res = error ? -1 : 0;
+        }
+        if (res != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+
+    if (fd >= 0) {
+        int flag = 1;
+        // records are coalesced by the sink
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+#ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &flag, sizeof(flag));
+#endif
+    }
+    return fd;
+}
+
+void TcpSink::Impl::run()
+{
+#ifdef MSG_NOSIGNAL
+    const int send_flags = MSG_NOSIGNAL;
+#else
+    const int send_flags = 0;
+#endif
+    int fd = -1;
+    std::vector<std::string> batch;
+    std::vector<struct iovec> iov;
+    size_t batch_length = 0;
+    size_t offset = 0;
+    unsigned int delay = 0;
+
+    while (true) {
+        if (fd < 0) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (stopping) {
+                    break;
+                }
+                delay = std::clamp(delay, reconnect_min_ms, reconnect_max_ms);
+            }
+            fd = open_connection();
+            if (fd < 0) {
+                if (!wait_reconnect(delay)) {
+                    break;
+                }
+                delay *= 2;
+                continue;
+            }
+            delay = 0;
+            // the interrupted batch is sent again
+            offset = 0;
+            set_connected(true);
+        }
+
+        if (offset == batch_length) {
+            batch.clear();
+            batch_length = 0;
+            offset = 0;
+            if (!take_batch(batch, batch_length)) {
+                break;
+            }
+            if (batch.empty()) {
+                // the collector isn't expected to send anything, a readable socket means it's closed
+                if (wait_event(fd, POLLIN, -1) & (POLLIN | POLLERR | POLLHUP)) {
+                    char buffer[256];
+                    ssize_t res = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+                    if (res == 0 || (res < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                        ::close(fd);
+                        fd = -1;
+                        set_connected(false);
+                    }
+                }
+                continue;
+            }
+        }
+
+        iov.clear();
+        size_t skip = offset;
+        for (auto &record : batch) {
+            if (skip >= record.length()) {
+                skip -= record.length();
+                continue;
+            }
+            iov.push_back({const_cast<char*>(record.data()) + skip, record.length() - skip});
+            skip = 0;
+        }
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = iov.data();
+        message.msg_iovlen = static_cast<decltype(message.msg_iovlen)>(iov.size());
+        ssize_t res = sendmsg(fd, &message, send_flags);
+        if (res >= 0) {
+            offset += res;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            wait_event(fd, POLLOUT, -1);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) {
+                break;
+            }
+        } else if (errno != EINTR) {
+            ::close(fd);
+            fd = -1;
+            set_connected(false);
+        }
+    }
+
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+/*
+ *
+ *  TcpSink class
+ *
+ */
+
+TcpSink::TcpSink(const std::string &host, uint16_t port, TcpFraming framing)
+    : pimpl(std::make_unique<Impl>(host, port, framing))
+{ }
+
+TcpSink::~TcpSink() = default;
+
+void TcpSink::set_buffer_limit(size_t size, DropPolicy policy)
+{
+    std::lock_guard<std::mutex> lock(pimpl->mutex);
+    pimpl->buffer_limit = size;
+    pimpl->drop_policy = policy;
+}
+
+void TcpSink::set_reconnect_delay(unsigned int min_ms, unsigned int max_ms)
+{
+    std::lock_guard<std::mutex> lock(pimpl->mutex);
+    pimpl->reconnect_min_ms = std::max(min_ms, 1u);
+    pimpl->reconnect_max_ms = std::max(max_ms, pimpl->reconnect_min_ms);
+}
+
+bool TcpSink::flush(unsigned int timeout_ms)
+{
+    return pimpl->flush(timeout_ms);
+}
+
+bool TcpSink::is_connected() const
+{
+    std::lock_guard<std::mutex> lock(pimpl->mutex);
+    return pimpl->connected;
+}
+
+uint64_t TcpSink::get_dropped_count() const
+{
+    return pimpl->dropped.load(std::memory_order_relaxed);
+}
+
+void TcpSink::write(ILogRecordData *record, IFormatter *logger_formatter)
+{
+    // the record is formatted after the space of the framing and moved to the queue
+    bool length_prefix = pimpl->framing == TcpFraming::LENGTH_PREFIX;
+    std::string text(length_prefix ? length_prefix_size : 0, '\0');
+
+    IFormatter *formatter = sink_formatter ? static_cast<IFormatter*>(sink_formatter.get()) : logger_formatter;
+    if (formatter) {
+        StringTextData data(text, length_prefix ? 0 : 1);
+        formatter->format_record(&data, record);
+    } else {
+        text.append(record->get_data());
+    }
+    pimpl->add_record(std::move(text));
+}
+
+} // namespace logging
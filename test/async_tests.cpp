@@ -0,0 +1,182 @@
+#include "gtest/gtest.h"
+#include <logging/sink/async.h>
+#include <logging/log_level.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include <condition_variable>
+#include "fake_record_data.h"
+
+using namespace logging;
+
+/**
+ * @brief Sink that keeps written records and can be stalled.
+ * 
+ */
+struct BlockingSink : public ILogSink
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool blocked = false;
+    bool entered = false;
+    std::vector<std::string> records;
+
+    virtual void write(ILogRecordData *record, IFormatter *) override
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        entered = true;
+        cv.notify_all();
+        cv.wait(lock, [this]() { return !blocked; });
+        records.push_back(record->get_data());
+    }
+
+    void block()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        blocked = true;
+        entered = false;
+    }
+
+    void wait_entered()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]() { return entered; });
+    }
+
+    void unblock()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        blocked = false;
+        cv.notify_all();
+    }
+};
+
+/*
+ *
+ *  AsyncSink tests
+ * 
+ */
+
+TEST(AsyncSinkTest, records)
+{
+    BlockingSink target;
+    AsyncSink sink{&target};
+    for (int i = 0; i < 100; ++i) {
+        std::string text = "message " + std::to_string(i);
+        FakeRecordData record{LogLevel::INFO, text.c_str(), "file.cpp", i};
+        sink.write(&record, nullptr);
+    }
+
+    EXPECT_TRUE(sink.flush(1000));
+    ASSERT_EQ(target.records.size(), 100u);
+    EXPECT_EQ(target.records[0], "message 0");
+    EXPECT_EQ(target.records[99], "message 99");
+
+    auto stats = sink.get_stats();
+    EXPECT_EQ(stats.written, 100u);
+    EXPECT_EQ(stats.dropped, 0u);
+    EXPECT_EQ(stats.queued, 0u);
+}
+
+TEST(AsyncSinkTest, drop_newest)
+{
+    BlockingSink target;
+    AsyncSink sink{&target, 3, DropPolicy::DROP_NEWEST};
+    target.block();
+
+    FakeRecordData first{LogLevel::INFO, "first"};
+    sink.write(&first, nullptr);
+    target.wait_entered();
+    // the writer doesn't wait for the stalled sink
+    for (int i = 0; i < 5; ++i) {
+        std::string text = "message " + std::to_string(i);
+        FakeRecordData record{LogLevel::INFO, text.c_str()};
+        sink.write(&record, nullptr);
+    }
+    EXPECT_FALSE(sink.flush(10));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    auto stats = sink.get_stats();
+    EXPECT_EQ(stats.dropped, 2u);
+    EXPECT_EQ(stats.queued, 4u);
+    EXPECT_GE(stats.lag_ms, 20u);
+
+    target.unblock();
+    EXPECT_TRUE(sink.flush(1000));
+    std::vector<std::string> expected{"first", "message 0", "message 1", "message 2"};
+    EXPECT_EQ(target.records, expected);
+    EXPECT_GE(sink.get_stats().max_lag_ms, 20u);
+}
+
+TEST(AsyncSinkTest, drop_oldest)
+{
+    BlockingSink target;
+    AsyncSink sink{&target, 3, DropPolicy::DROP_OLDEST};
+    target.block();
+
+    FakeRecordData first{LogLevel::INFO, "first"};
+    sink.write(&first, nullptr);
+    target.wait_entered();
+    for (int i = 0; i < 5; ++i) {
+        std::string text = "message " + std::to_string(i);
+        FakeRecordData record{LogLevel::INFO, text.c_str()};
+        sink.write(&record, nullptr);
+    }
+
+    target.unblock();
+    EXPECT_TRUE(sink.flush(1000));
+    std::vector<std::string> expected{"first", "message 2", "message 3", "message 4"};
+    EXPECT_EQ(target.records, expected);
+    EXPECT_EQ(sink.get_stats().dropped, 2u);
+}
+
+TEST(AsyncSinkTest, isolated_sinks)
+{
+    BlockingSink stalled_target, target;
+    AsyncSink stalled_sink{&stalled_target}, sink{&target};
+    stalled_target.block();
+
+    FakeRecordData record{LogLevel::INFO, "message"};
+    stalled_sink.write(&record, nullptr);
+    sink.write(&record, nullptr);
+
+    EXPECT_TRUE(sink.flush(1000));
+    EXPECT_EQ(target.records.size(), 1u);
+    EXPECT_FALSE(stalled_sink.flush(10));
+
+    stalled_target.unblock();
+}
+
+TEST(AsyncSinkTest, failed_writes)
+{
+    struct ThrowingSink : public ILogSink
+    {
+        std::vector<std::string> records;
+
+        virtual void write(ILogRecordData *record, IFormatter *) override
+        {
+            std::string text = record->get_data();
+            if (text == "bad") {
+                throw std::runtime_error("write failed");
+            }
+            records.push_back(text);
+        }
+    };
+
+    ThrowingSink target;
+    AsyncSink sink{&target};
+    for (auto text : {"first", "bad", "second", "bad", "third"}) {
+        FakeRecordData record{LogLevel::INFO, text};
+        sink.write(&record, nullptr);
+    }
+
+    // the thread goes on after the exceptions
+    EXPECT_TRUE(sink.flush(1000));
+    std::vector<std::string> expected{"first", "second", "third"};
+    EXPECT_EQ(target.records, expected);
+    auto stats = sink.get_stats();
+    EXPECT_EQ(stats.written, 3u);
+    EXPECT_EQ(stats.failed, 2u);
+}
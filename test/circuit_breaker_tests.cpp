@@ -0,0 +1,138 @@
+#include "gtest/gtest.h"
+#include <logging/sink/circuit_breaker.h>
+#include <logging/sink/ring.h>
+#include <logging/log_level.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include "fake_record_data.h"
+
+using namespace logging;
+
+/**
+ * @brief Sink that can be slowed down or made failing.
+ * 
+ */
+struct FaultySink : public ILogSink
+{
+    std::atomic<unsigned int> delay_ms{0};
+    std::atomic<bool> failing{false};
+    std::atomic<unsigned int> written{0};
+
+    virtual void write(ILogRecordData *, IFormatter *) override
+    {
+        if (delay_ms) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+        }
+        if (failing) {
+            throw std::runtime_error("write failed");
+        }
+        ++written;
+    }
+};
+
+/*
+ *
+ *  CircuitBreakerSink tests
+ * 
+ */
+
+TEST(CircuitBreakerSinkTest, closed)
+{
+    FaultySink target;
+    CircuitBreakerSink sink{&target};
+    FakeRecordData record{LogLevel::INFO, "message"};
+    for (int i = 0; i < 10; ++i) {
+        sink.write(&record, nullptr);
+    }
+
+    auto stats = sink.get_stats();
+    EXPECT_EQ(target.written, 10u);
+    EXPECT_EQ(stats.state, CircuitState::CLOSED);
+    EXPECT_EQ(stats.trips, 0u);
+    EXPECT_EQ(stats.diverted, 0u);
+}
+
+TEST(CircuitBreakerSinkTest, slow_write_trips)
+{
+    FaultySink target;
+    RingSink fallback{4096};
+    CircuitBreakerPolicy policy;
+    policy.timeout_ms = 10;
+    policy.probe_interval_ms = 50;
+    CircuitBreakerSink sink{&target, &fallback, policy};
+
+    target.delay_ms = 30;
+    FakeRecordData slow_record{LogLevel::INFO, "slow"};
+    sink.write(&slow_record, nullptr);
+    EXPECT_EQ(sink.get_stats().state, CircuitState::OPEN);
+
+    target.delay_ms = 0;
+    FakeRecordData record{LogLevel::INFO, "diverted"};
+    sink.write(&record, nullptr);
+    EXPECT_EQ(target.written, 1u);
+    auto records = fallback.snapshot();
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(records[0].text, "diverted");
+
+    // the probe closes the breaker
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    sink.write(&record, nullptr);
+    auto stats = sink.get_stats();
+    EXPECT_EQ(target.written, 2u);
+    EXPECT_EQ(stats.state, CircuitState::CLOSED);
+    EXPECT_EQ(stats.trips, 1u);
+    EXPECT_EQ(stats.diverted, 1u);
+    EXPECT_GE(stats.max_write_us, 30000u);
+}
+
+TEST(CircuitBreakerSinkTest, hung_write_trips)
+{
+    FaultySink target;
+    CircuitBreakerPolicy policy;
+    policy.timeout_ms = 10;
+    CircuitBreakerSink sink{&target, nullptr, policy};
+
+    target.delay_ms = 200;
+    FakeRecordData record{LogLevel::INFO, "message"};
+    std::thread hung_thread([&]() { sink.write(&record, nullptr); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+
+    // the record doesn't wait for the hung write
+    auto start = std::chrono::steady_clock::now();
+    sink.write(&record, nullptr);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(100));
+
+    auto stats = sink.get_stats();
+    EXPECT_EQ(stats.state, CircuitState::OPEN);
+    EXPECT_EQ(stats.diverted, 1u);
+    hung_thread.join();
+}
+
+TEST(CircuitBreakerSinkTest, error_rate_trips)
+{
+    FaultySink target;
+    CircuitBreakerPolicy policy;
+    policy.error_rate = 0.5;
+    policy.window = 4;
+    policy.probe_interval_ms = 10000;
+    CircuitBreakerSink sink{&target, nullptr, policy};
+
+    FakeRecordData record{LogLevel::INFO, "message"};
+    sink.write(&record, nullptr);
+    sink.write(&record, nullptr);
+    target.failing = true;
+    sink.write(&record, nullptr);
+    EXPECT_EQ(sink.get_stats().state, CircuitState::CLOSED);
+    sink.write(&record, nullptr);
+    EXPECT_EQ(sink.get_stats().state, CircuitState::OPEN);
+
+    sink.write(&record, nullptr);
+    auto stats = sink.get_stats();
+    EXPECT_EQ(stats.failed, 2u);
+    EXPECT_EQ(stats.diverted, 3u);
+    EXPECT_EQ(stats.trips, 1u);
+}
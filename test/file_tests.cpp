@@ -1,10 +1,19 @@
 #include "gtest/gtest.h"
 #include <logging/logger.h>
 #include <logging/sink/file.h>
+#include <logging/helper/datetime.h>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <thread>
+#include <atomic>
+#include <set>
+#include <map>
+#include <sstream>
 #include "fake_record_data.h"
+#ifdef LOGGING_WITH_ZLIB
+#include <zlib.h>
+#endif
 
 using namespace logging;
 
@@ -147,6 +156,47 @@ TEST_F(FileTest, rotate_files_by_hour)
     }
 }
 
+TEST_F(FileTest, rotation_boundaries)
+{
+    std::string path = "test_logs/log_boundaries/";
+    for (auto time_format : {"%Y_%W", "%Y-%m", "%Y-%j", "%m-%d_%H"}) {
+        std::filesystem::remove_all(path);
+        SetUp(path + time_format + ".log");
+        FakeRecordData record;
+        // 3 hours and 1 second steps cross the boundaries at different offsets
+        const int64_t step = (3 * 3600 + 1) * 1000;
+        std::map<std::string, std::string> expected_files;
+        for (int i = 0; i < 400; ++i) {
+            record.milliseconds += step;
+            record.data = "line" + std::to_string(i);
+            file_sink->write(&record, nullptr);
+
+            std::tm datetime;
+            time_t time = static_cast<time_t>(record.milliseconds / 1000);
+            local_datetime(&datetime, time);
+            char name[64];
+            std::strftime(name, sizeof(name), time_format, &datetime);
+            expected_files[path + name + ".log"] += record.data + "\n";
+        }
+        // a record earlier than the current file is written to it, the files aren't reopened
+        std::string last_filename = file_sink->get_filename();
+        record.milliseconds -= 40 * 24 * 3600 * 1000LL;
+        record.data = "late line";
+        file_sink->write(&record, nullptr);
+        EXPECT_EQ(file_sink->get_filename(), last_filename);
+        expected_files[last_filename] += record.data + "\n";
+        file_sink.reset();
+
+        for (auto &[filename, data] : expected_files) {
+            std::string file_data = read_file(filename.c_str());
+            EXPECT_EQ(file_data.substr(0, data.length()), data) << filename;
+        }
+    }
+
+    std::filesystem::remove_all(path);
+    SetUp(file_template);
+}
+
 TEST_F(FileTest, rotate_files_max_5)
 {
     std::string path = "test_logs/log_max_5/";
@@ -166,6 +216,8 @@ TEST_F(FileTest, rotate_files_max_5)
     EXPECT_GE(filenames.size(), 6);
     EXPECT_LE(filenames.size(), 10);
 
+    // old files are removed in the background
+    file_sink->flush();
     std::filesystem::path dir{filenames[0]};
     dir.remove_filename();
     size_t count = 0;
@@ -211,4 +263,1030 @@ TEST_F(FileTest, template_end_slash)
     } catch(...) {
         FAIL();
     }
-}
\ No newline at end of file
+}
+
+TEST_F(FileTest, buffered_lines)
+{
+    FlushPolicy policy;
+    policy.buffer_size = 64;
+    file_sink->set_flush_policy(policy);
+    FakeRecordData record1(LogLevel::INFO, "line_1");
+    FakeRecordData record2(LogLevel::INFO, "line_2");
+
+    file_sink->write(&record1, nullptr);
+    file_sink->write(&record2, nullptr);
+    EXPECT_EQ(read_file(), "");
+
+    file_sink->flush();
+    EXPECT_EQ(read_file(), "line_1\nline_2\n");
+}
+
+TEST_F(FileTest, buffered_lines_size_limit)
+{
+    FlushPolicy policy;
+    policy.buffer_size = 10;
+    file_sink->set_flush_policy(policy);
+    FakeRecordData record1(LogLevel::INFO, "line_1");
+    FakeRecordData record2(LogLevel::INFO, "line_2");
+    FakeRecordData record3(LogLevel::INFO, "line_3");
+
+    file_sink->write(&record1, nullptr);
+    EXPECT_EQ(read_file(), "");
+    file_sink->write(&record2, nullptr);
+    EXPECT_EQ(read_file(), "line_1\nline_2\n");
+    file_sink->write(&record3, nullptr);
+    EXPECT_EQ(read_file(), "line_1\nline_2\n");
+}
+
+TEST_F(FileTest, buffered_lines_flush_level)
+{
+    FlushPolicy policy;
+    policy.buffer_size = 1024;
+    policy.flush_level = LogLevel::WARNING;
+    file_sink->set_flush_policy(policy);
+    FakeRecordData record1(LogLevel::INFO, "line_1");
+    FakeRecordData record2(LogLevel::WARNING, "line_2");
+
+    file_sink->write(&record1, nullptr);
+    EXPECT_EQ(read_file(), "");
+    file_sink->write(&record2, nullptr);
+    EXPECT_EQ(read_file(), "line_1\nline_2\n");
+}
+
+TEST_F(FileTest, buffered_lines_flush_interval)
+{
+    FlushPolicy policy;
+    policy.buffer_size = 1024;
+    policy.interval_ms = 10;
+    file_sink->set_flush_policy(policy);
+    FakeRecordData record(LogLevel::INFO, "line_1");
+
+    file_sink->write(&record, nullptr);
+    for (int i = 0; i < 100 && read_file().empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    EXPECT_EQ(read_file(), "line_1\n");
+}
+
+TEST_F(FileTest, buffered_lines_on_close)
+{
+    FlushPolicy policy;
+    policy.buffer_size = 1024;
+    file_sink->set_flush_policy(policy);
+    FakeRecordData record(LogLevel::INFO, "line_1");
+
+    file_sink->write(&record, nullptr);
+    std::string filename = file_sink->get_filename();
+    add_file(filename);
+    file_sink = std::make_unique<FileSink>(file_template);
+
+    EXPECT_EQ(read_file(filename.c_str()), "line_1\n");
+}
+
+TEST_F(FileTest, fd_writer_lines)
+{
+    file_sink->set_file_writer(FileWriter::FD);
+    std::string expected_data;
+    for (int i = 0; i < 10; ++i)
+    {
+        std::string line = "line_" + std::to_string(i + 1);
+        FakeRecordData record(LogLevel::INFO, line.c_str());
+        file_sink->write(&record, nullptr);
+        expected_data.append(line);
+        expected_data.append("\n");
+        EXPECT_EQ(read_file(), expected_data);
+    }
+}
+
+TEST_F(FileTest, fd_writer_buffered_lines)
+{
+    file_sink->set_file_writer(FileWriter::FD);
+    FlushPolicy policy;
+    policy.buffer_size = 1024 * 1024;
+    file_sink->set_flush_policy(policy);
+    std::string expected_data;
+    for (int i = 0; i < 5000; ++i)
+    {
+        std::string line = "line_" + std::to_string(i + 1);
+        FakeRecordData record(LogLevel::INFO, line.c_str());
+        file_sink->write(&record, nullptr);
+        expected_data.append(line);
+        expected_data.append("\n");
+    }
+    EXPECT_EQ(read_file(), "");
+
+    file_sink->flush();
+    EXPECT_EQ(read_file(), expected_data);
+}
+
+TEST_F(FileTest, large_records)
+{
+    for (auto writer : {FileWriter::STREAM, FileWriter::FD}) {
+        SetUp(file_template);
+        std::filesystem::remove(file_template);
+        file_sink->set_file_writer(writer);
+        file_sink->set_formatter(Formatter("<${level_name}> ${message} | ${message}"));
+        FlushPolicy policy;
+        policy.buffer_size = 1024 * 1024;
+        file_sink->set_flush_policy(policy);
+
+        std::string expected_data;
+        for (int i = 0; i < 20; ++i) {
+            // large messages are written with the buffered records
+            std::string line = i % 5 == 4 ? std::string(10000 + i, 'a' + i) : "line_" + std::to_string(i + 1);
+            FakeRecordData record(LogLevel::INFO, line.c_str());
+            file_sink->write(&record, nullptr);
+            expected_data.append("<INFO> " + line + " | " + line + "\n");
+        }
+        file_sink->flush();
+        EXPECT_EQ(read_file(), expected_data);
+    }
+}
+
+TEST_F(FileTest, fd_writer_rotate_files_by_day)
+{
+    SetUp("test_logs/rotation_test_fd_day_%Y-%m-%d.log");
+    file_sink->set_file_writer(FileWriter::FD);
+    FakeRecordData record1(LogLevel::INFO, "line_1");
+    FakeRecordData record2(LogLevel::INFO, "line_2", "test.cpp", 0, record1.milliseconds + (24 + 2) * 3600 * 1000);
+
+    file_sink->write(&record1, nullptr);
+    add_file(file_sink->get_filename());
+    file_sink->write(&record2, nullptr);
+
+    EXPECT_EQ(read_file(filenames[0].c_str()), "line_1\n");
+    EXPECT_EQ(read_file(), "line_2\n");
+}
+
+TEST_F(FileTest, mmap_writer_lines)
+{
+    file_sink->set_file_writer(FileWriter::MMAP);
+    std::string expected_data;
+    for (int i = 0; i < 10; ++i)
+    {
+        std::string line = "line_" + std::to_string(i + 1);
+        FakeRecordData record(LogLevel::INFO, line.c_str());
+        file_sink->write(&record, nullptr);
+        expected_data.append(line);
+        expected_data.append("\n");
+    }
+    std::string filename = file_sink->get_filename();
+    add_file(filename);
+    EXPECT_EQ(read_file().substr(0, expected_data.length()), expected_data);
+
+    // reopen the file, so it is truncated to the data length
+    file_sink->set_file_writer(FileWriter::STREAM);
+    EXPECT_EQ(read_file(filename.c_str()), expected_data);
+}
+
+TEST_F(FileTest, mmap_writer_append_and_grow)
+{
+    FakeRecordData record1(LogLevel::INFO, "first");
+    file_sink->write(&record1, nullptr);
+    file_sink->set_file_writer(FileWriter::MMAP);
+
+    std::string expected_data = "first\n";
+    std::string line(1000, 'x');
+    for (int i = 0; i < 5000; ++i)
+    {
+        FakeRecordData record(LogLevel::INFO, line.c_str());
+        file_sink->write(&record, nullptr);
+        expected_data.append(line);
+        expected_data.append("\n");
+    }
+    std::string filename = file_sink->get_filename();
+    add_file(filename);
+    file_sink->set_file_writer(FileWriter::STREAM);
+
+    EXPECT_EQ(std::filesystem::file_size(filename), expected_data.length());
+    EXPECT_EQ(read_file(filename.c_str()), expected_data);
+}
+
+TEST_F(FileTest, uring_writer_lines)
+{
+    std::string dir = std::filesystem::exists("/dev/shm") ? "/dev/shm/" : "test_logs/";
+    SetUp(dir + "logging_uring_test.log");
+    file_sink->set_file_writer(FileWriter::URING);
+    FlushPolicy policy;
+    policy.buffer_size = 4096;
+    file_sink->set_flush_policy(policy);
+
+    std::string expected_data;
+    std::string filler(100, 'x');
+    for (int i = 0; i < 20000; ++i)
+    {
+        std::string line = "line_" + std::to_string(i + 1) + (i % 1000 ? "" : filler);
+        FakeRecordData record(LogLevel::INFO, line.c_str());
+        file_sink->write(&record, nullptr);
+        expected_data.append(line);
+        expected_data.append("\n");
+    }
+    std::string huge_line(1024 * 1024, 'y');
+    FakeRecordData record(LogLevel::INFO, huge_line.c_str());
+    file_sink->write(&record, nullptr);
+    expected_data.append(huge_line);
+    expected_data.append("\n");
+
+    std::string filename = file_sink->get_filename();
+    add_file(filename);
+    // close the file to wait for completion of all writes
+    file_sink->set_file_writer(FileWriter::STREAM);
+
+    EXPECT_EQ(read_file(filename.c_str()), expected_data);
+}
+
+TEST_F(FileTest, uring_writer_unbuffered)
+{
+    std::string dir = std::filesystem::exists("/dev/shm") ? "/dev/shm/" : "test_logs/";
+    SetUp(dir + "logging_uring_unbuffered_test.log");
+    file_sink->set_file_writer(FileWriter::URING);
+
+    // every record is flushed and submitted after the previous write completes
+    std::string expected_data;
+    for (int i = 0; i < 2000; ++i)
+    {
+        std::string line = "line_" + std::to_string(i + 1);
+        FakeRecordData record(LogLevel::INFO, line.c_str());
+        file_sink->write(&record, nullptr);
+        expected_data.append(line);
+        expected_data.append("\n");
+    }
+
+    std::string filename = file_sink->get_filename();
+    add_file(filename);
+    file_sink->sync();
+    EXPECT_EQ(read_file(filename.c_str()), expected_data);
+}
+
+TEST_F(FileTest, rotate_files_by_size)
+{
+    std::string path = "test_logs/log_by_size/";
+    std::filesystem::remove_all(path);
+    SetUp(path + "size_test_%i.log");
+    file_sink->set_max_file_size(100);
+    std::string expected_data;
+
+    for (int i = 0; i < 50; ++i) {
+        FakeRecordData record(LogLevel::INFO, ("line_" + std::to_string(i + 100)).c_str());
+        file_sink->write(&record, nullptr);
+        expected_data.append(record.data + "\n");
+    }
+    file_sink.reset();
+
+    std::string data;
+    for (int i = 0; i < 5; ++i) {
+        std::string filename = path + "size_test_" + std::to_string(i) + ".log";
+        EXPECT_LE(std::filesystem::file_size(filename), 100);
+        data.append(read_file(filename.c_str()));
+    }
+    EXPECT_EQ(data, expected_data);
+    EXPECT_FALSE(std::filesystem::exists(path + "size_test_5.log"));
+
+    std::filesystem::remove_all(path);
+    SetUp(file_template);
+}
+
+TEST_F(FileTest, rotate_files_by_size_existing)
+{
+    std::string path = "test_logs/log_by_size_existing/";
+    std::filesystem::remove_all(path);
+    std::filesystem::create_directories(path);
+    std::ofstream(path + "size_test_0.log") << std::string(99, 'x') << "\n";
+    SetUp(path + "size_test_%i.log");
+    file_sink->set_max_file_size(100);
+
+    FakeRecordData record(LogLevel::INFO, "line");
+    file_sink->write(&record, nullptr);
+
+    EXPECT_EQ(file_sink->get_filename(), path + "size_test_1.log");
+    EXPECT_EQ(read_file(), "line\n");
+
+    file_sink.reset();
+    std::filesystem::remove_all(path);
+    SetUp(file_template);
+}
+
+TEST_F(FileTest, rotate_files_by_size_and_time)
+{
+    std::string path = "test_logs/log_by_size_time/";
+    std::filesystem::remove_all(path);
+    SetUp(path + "size_test_%Y-%m-%d_%H.%i.log");
+    file_sink->set_max_file_size(50);
+    FakeRecordData record(LogLevel::INFO, "line_000");
+
+    for (int i = 0; i < 12; ++i) {
+        record.milliseconds += 20 * 60 * 1000;
+        file_sink->write(&record, nullptr);
+    }
+    file_sink.reset();
+
+    size_t count = 0, size = 0;
+    for (auto& p: std::filesystem::directory_iterator(path)) {
+        size += std::filesystem::file_size(p.path());
+        ++count;
+    }
+    EXPECT_EQ(size, 12 * 9);
+    EXPECT_GE(count, 4);
+    EXPECT_LE(count, 5);
+
+    std::filesystem::remove_all(path);
+    SetUp(file_template);
+}
+
+TEST_F(FileTest, prepare_next_period_file)
+{
+    std::string path = "test_logs/log_prepare/";
+    std::filesystem::remove_all(path);
+    SetUp(path + "prepare_%Y-%m-%d_%H.log");
+    // the next hour is always within the lead time
+    file_sink->set_prepare_ahead(2 * 3600 * 1000, 64 * 1024);
+
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    FakeRecordData record;
+    record.milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+    record.data = "current hour";
+    file_sink->write(&record, nullptr);
+
+    std::tm datetime;
+    local_datetime(&datetime, static_cast<time_t>(record.milliseconds / 1000 + 3600));
+    char name[64];
+    std::strftime(name, sizeof(name), "prepare_%Y-%m-%d_%H.log", &datetime);
+    std::string next_filename = path + name;
+
+    for (int i = 0; i < 500 && !std::filesystem::exists(next_filename); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(std::filesystem::exists(next_filename));
+    EXPECT_EQ(std::filesystem::file_size(next_filename), 0);
+
+    record.milliseconds += 3600 * 1000;
+    record.data = "next hour";
+    file_sink->write(&record, nullptr);
+    EXPECT_EQ(file_sink->get_filename(), next_filename);
+    file_sink->flush();
+    EXPECT_EQ(read_file(next_filename.c_str()), "next hour\n");
+
+    // the file prepared for the following hour is removed with the sink
+    local_datetime(&datetime, static_cast<time_t>(record.milliseconds / 1000 + 3600));
+    std::strftime(name, sizeof(name), "prepare_%Y-%m-%d_%H.log", &datetime);
+    std::string unused_filename = path + name;
+    for (int i = 0; i < 500 && !std::filesystem::exists(unused_filename); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(std::filesystem::exists(unused_filename));
+    file_sink.reset();
+    EXPECT_FALSE(std::filesystem::exists(unused_filename));
+
+    std::filesystem::remove_all(path);
+    SetUp(file_template);
+}
+
+TEST_F(FileTest, size_rotation_without_index)
+{
+    try {
+        file_sink->set_max_file_size(100);
+        FAIL();
+    } catch (FileTemplateException&) {
+        SUCCEED();
+    } catch(...) {
+        FAIL();
+    }
+}
+
+TEST_F(FileTest, rotate_files_max_total_size)
+{
+    std::string path = "test_logs/log_max_size/";
+    std::filesystem::remove_all(path);
+    std::filesystem::create_directories(path);
+    for (int i = 0; i < 20; ++i) {
+        std::ofstream(path + "size_test_" + std::to_string(i) + ".log") << std::string(99, 'x') << "\n";
+    }
+    std::ofstream(path + "other.log") << std::string(1000, 'x') << "\n";
+    SetUp(path + "size_test_%i.log");
+    file_sink->set_max_file_size(100);
+    file_sink->set_max_total_size(450);
+
+    FakeRecordData record(LogLevel::INFO, "line");
+    file_sink->write(&record, nullptr);
+    file_sink->flush();
+
+    std::vector<std::string> names;
+    for (auto& p: std::filesystem::directory_iterator(path)) {
+        names.push_back(p.path().filename().string());
+    }
+    std::sort(names.begin(), names.end());
+    // size_test_21.log is the next file created ahead of time
+    std::vector<std::string> expected_names{
+        "other.log", "size_test_16.log", "size_test_17.log", "size_test_18.log",
+        "size_test_19.log", "size_test_20.log", "size_test_21.log"
+    };
+    EXPECT_EQ(names, expected_names);
+
+    file_sink.reset();
+    std::filesystem::remove_all(path);
+    SetUp(file_template);
+}
+
+TEST_F(FileTest, rotate_files_max_files_existing)
+{
+    std::string path = "test_logs/log_max_files/";
+    std::filesystem::remove_all(path);
+    std::filesystem::create_directories(path);
+    for (int i = 0; i < 20; ++i) {
+        std::ofstream(path + "size_test_" + std::to_string(i) + ".log") << std::string(99, 'x') << "\n";
+    }
+    SetUp(path + "size_test_%i.log", 3);
+    file_sink->set_max_file_size(100);
+
+    FakeRecordData record(LogLevel::INFO, std::string(60, 'y').c_str());
+    for (int i = 0; i < 5; ++i) {
+        file_sink->write(&record, nullptr);
+    }
+    file_sink->flush();
+
+    std::vector<std::string> names;
+    for (auto& p: std::filesystem::directory_iterator(path)) {
+        names.push_back(p.path().filename().string());
+    }
+    std::sort(names.begin(), names.end());
+    // size_test_25.log is the next file created ahead of time
+    std::vector<std::string> expected_names{
+        "size_test_22.log", "size_test_23.log", "size_test_24.log", "size_test_25.log"
+    };
+    EXPECT_EQ(names, expected_names);
+
+    file_sink.reset();
+    std::filesystem::remove_all(path);
+    SetUp(file_template);
+}
+
+TEST_F(FileTest, sync_every_record)
+{
+    SyncPolicy policy;
+    policy.records = 1;
+    file_sink->set_sync_policy(policy);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([this]() {
+            FakeRecordData record(LogLevel::INFO, "line");
+            for (int i = 0; i < 10; ++i) {
+                file_sink->write(&record, nullptr);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    auto stats = file_sink->get_sync_stats();
+    EXPECT_EQ(stats.commits, 40u);
+#ifdef __unix__
+    EXPECT_GE(stats.syncs, 1u);
+    EXPECT_LE(stats.syncs, 40u);
+#endif
+    EXPECT_GE(stats.total_commit_us, stats.max_commit_us);
+
+    std::string expected;
+    for (int i = 0; i < 40; ++i) {
+        expected += "line\n";
+    }
+    EXPECT_EQ(read_file(), expected);
+}
+
+TEST_F(FileTest, sync_on_level)
+{
+    SyncPolicy policy;
+    policy.sync_level = LogLevel::ERROR;
+    file_sink->set_sync_policy(policy);
+
+    FakeRecordData info(LogLevel::INFO, "info");
+    file_sink->write(&info, nullptr);
+    EXPECT_EQ(file_sink->get_sync_stats().commits, 0u);
+
+    FakeRecordData error(LogLevel::ERROR, "error");
+    file_sink->write(&error, nullptr);
+    EXPECT_EQ(file_sink->get_sync_stats().commits, 1u);
+
+    file_sink->sync();
+    EXPECT_EQ(file_sink->get_sync_stats().commits, 2u);
+    EXPECT_EQ(read_file(), "info\nerror\n");
+}
+
+TEST_F(FileTest, sync_interval)
+{
+    SyncPolicy policy;
+    policy.interval_ms = 10;
+    file_sink->set_sync_policy(policy);
+
+    FakeRecordData record(LogLevel::FATAL, "line");
+    file_sink->write(&record, nullptr);
+    for (int i = 0; i < 100 && !file_sink->get_sync_stats().syncs; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    auto stats = file_sink->get_sync_stats();
+    EXPECT_EQ(stats.commits, 0u);
+#ifdef __unix__
+    EXPECT_EQ(stats.syncs, 1u);
+#endif
+    EXPECT_EQ(read_file(), "line\n");
+}
+
+#ifdef __unix__
+TEST_F(FileTest, sync_failure)
+{
+    // fdatasync fails with EINVAL on a special file
+    FileSink sink("/dev/null");
+    SyncPolicy policy;
+    policy.records = 1;
+    sink.set_sync_policy(policy);
+
+    FakeRecordData record(LogLevel::INFO, "line");
+    sink.write(&record, nullptr);
+    EXPECT_FALSE(sink.sync());
+
+    auto stats = sink.get_sync_stats();
+    EXPECT_EQ(stats.syncs, 0u);
+    EXPECT_GE(stats.failures, 2u);
+    EXPECT_EQ(stats.commits, 2u);
+
+    EXPECT_TRUE(file_sink->sync());
+    EXPECT_EQ(file_sink->get_sync_stats().failures, 0u);
+}
+#endif
+
+TEST_F(FileTest, concurrent_writers)
+{
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([this, t]() {
+            for (int i = 0; i < 1000; ++i) {
+                std::string text = "thread_" + std::to_string(t) + "_" + std::to_string(i);
+                FakeRecordData record(LogLevel::INFO, text.c_str());
+                file_sink->write(&record, nullptr);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    file_sink->flush();
+
+    std::istringstream stream(read_file());
+    std::vector<int> next_index(4, 0);
+    std::string line;
+    size_t count = 0;
+    while (std::getline(stream, line)) {
+        // records of a thread keep their order
+        int t = line[7] - '0';
+        ASSERT_EQ(line, "thread_" + std::to_string(t) + "_" + std::to_string(next_index[t]));
+        ++next_index[t];
+        ++count;
+    }
+    EXPECT_EQ(count, 4000);
+}
+
+TEST_F(FileTest, thread_shards)
+{
+    std::string path = "test_logs/log_shards/";
+    std::filesystem::remove_all(path);
+    SetUp(path + "shard_%t.log");
+
+    std::vector<std::string> filenames(3);
+    std::vector<std::thread> threads;
+    std::atomic<int> written{0};
+    for (int t = 0; t < 3; ++t) {
+        threads.emplace_back([this, t, &filenames, &written]() {
+            for (int i = 0; i < 100; ++i) {
+                std::string text = "thread_" + std::to_string(t) + "_" + std::to_string(i);
+                FakeRecordData record(LogLevel::INFO, text.c_str());
+                file_sink->write(&record, nullptr);
+            }
+            filenames[t] = file_sink->get_filename();
+            // numbers of exited threads are reused, the threads run together
+            ++written;
+            while (written < 3) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    file_sink->flush();
+    EXPECT_EQ(file_sink->get_filename(), "");
+
+    std::set<std::string> unique_names(filenames.begin(), filenames.end());
+    EXPECT_EQ(unique_names.size(), 3);
+    for (int t = 0; t < 3; ++t) {
+        EXPECT_EQ(filenames[t].compare(0, path.length() + 6, path + "shard_"), 0);
+        std::string expected;
+        for (int i = 0; i < 100; ++i) {
+            expected += "thread_" + std::to_string(t) + "_" + std::to_string(i) + "\n";
+        }
+        EXPECT_EQ(read_file(filenames[t].c_str()), expected);
+    }
+
+    file_sink.reset();
+    std::filesystem::remove_all(path);
+    SetUp(file_template);
+}
+
+TEST_F(FileTest, thread_shards_reused)
+{
+    std::string path = "test_logs/log_shards_reused/";
+    std::filesystem::remove_all(path);
+    SetUp(path + "shard_%t.log");
+
+    std::string expected;
+    std::string filename;
+    for (int t = 0; t < 5; ++t) {
+        std::thread thread([this, t, &filename]() {
+            for (int i = 0; i < 10; ++i) {
+                std::string text = "thread_" + std::to_string(t) + "_" + std::to_string(i);
+                FakeRecordData record(LogLevel::INFO, text.c_str());
+                file_sink->write(&record, nullptr);
+            }
+            filename = file_sink->get_filename();
+        });
+        thread.join();
+        for (int i = 0; i < 10; ++i) {
+            expected += "thread_" + std::to_string(t) + "_" + std::to_string(i) + "\n";
+        }
+        // the shard of the exited thread is closed
+        EXPECT_EQ(read_file(filename.c_str()), expected);
+    }
+
+    // the threads took the same number one after another
+    auto files = std::distance(std::filesystem::directory_iterator(path), std::filesystem::directory_iterator{});
+    EXPECT_EQ(files, 1);
+
+    file_sink.reset();
+    std::filesystem::remove_all(path);
+    SetUp(file_template);
+}
+
+#ifdef __unix__
+
+TEST_F(FileTest, shared_mode_writers)
+{
+    std::string path = "test_logs/log_shared/";
+    std::filesystem::remove_all(path);
+    std::string shared_template = path + "shared_%i.log";
+    SetUp(shared_template);
+    auto other_sink = std::make_unique<FileSink>(shared_template);
+    for (auto sink : {file_sink.get(), other_sink.get()}) {
+        EXPECT_TRUE(sink->set_shared_mode(true));
+        sink->set_max_file_size(100);
+    }
+
+    std::set<std::string> expected_lines;
+    auto write_records = [&](FileSink *sink, const std::string &prefix) {
+        for (int i = 0; i < 50; ++i) {
+            std::string text = prefix + std::to_string(i);
+            FakeRecordData record(LogLevel::INFO, text.c_str());
+            sink->write(&record, nullptr);
+        }
+    };
+    for (int i = 0; i < 50; ++i) {
+        expected_lines.insert("first_" + std::to_string(i));
+        expected_lines.insert("second_" + std::to_string(i));
+    }
+    std::thread other_thread(write_records, other_sink.get(), "second_");
+    write_records(file_sink.get(), "first_");
+    other_thread.join();
+    file_sink.reset();
+    other_sink.reset();
+
+    std::set<std::string> lines;
+    size_t count = 0, files = 0;
+    for (auto& p: std::filesystem::directory_iterator(path)) {
+        if (p.path().filename() == ".shared_%i.log.lock") {
+            continue;
+        }
+        ++files;
+        std::istringstream stream(read_file(p.path().string().c_str()));
+        std::string line;
+        while (std::getline(stream, line)) {
+            lines.insert(line);
+            ++count;
+        }
+    }
+    EXPECT_EQ(count, 100);
+    EXPECT_EQ(lines, expected_lines);
+    EXPECT_GE(files, 5);
+    EXPECT_TRUE(std::filesystem::exists(path + ".shared_%i.log.lock"));
+
+    std::filesystem::remove_all(path);
+    SetUp(file_template);
+}
+
+TEST_F(FileTest, shared_mode_max_files)
+{
+    std::string path = "test_logs/log_shared_max_files/";
+    std::filesystem::remove_all(path);
+    std::string shared_template = path + "shared_%i.log";
+    SetUp(shared_template, 3);
+    auto other_sink = std::make_unique<FileSink>(shared_template, 3);
+    for (auto sink : {file_sink.get(), other_sink.get()}) {
+        EXPECT_TRUE(sink->set_shared_mode(true));
+        sink->set_max_file_size(100);
+    }
+
+    FakeRecordData record(LogLevel::INFO, std::string(60, 'y').c_str());
+    for (int i = 0; i < 6; ++i) {
+        file_sink->write(&record, nullptr);
+        other_sink->write(&record, nullptr);
+    }
+    file_sink->flush();
+    other_sink->flush();
+
+    std::vector<std::string> names;
+    for (auto& p: std::filesystem::directory_iterator(path)) {
+        names.push_back(p.path().filename().string());
+    }
+    std::sort(names.begin(), names.end());
+    // both sinks append to the same files, there is no file opened ahead of time
+    std::vector<std::string> expected_names{
+        ".shared_%i.log.lock", "shared_3.log", "shared_4.log", "shared_5.log"
+    };
+    EXPECT_EQ(names, expected_names);
+    EXPECT_EQ(file_sink->get_filename(), path + "shared_5.log");
+    EXPECT_EQ(other_sink->get_filename(), path + "shared_5.log");
+
+    file_sink.reset();
+    other_sink.reset();
+    std::filesystem::remove_all(path);
+    SetUp(file_template);
+}
+
+#endif
+
+TEST_F(FileTest, compression_not_supported)
+{
+#ifndef LOGGING_WITH_ZSTD
+    EXPECT_FALSE(file_sink->set_compression(Compression::ZSTD));
+#endif
+    EXPECT_TRUE(file_sink->set_compression(Compression::NONE));
+}
+
+#ifdef LOGGING_WITH_ZLIB
+
+static std::string read_gzip_file(const std::string &filename)
+{
+    std::string result;
+    gzFile file = gzopen(filename.c_str(), "rb");
+    if (file) {
+        char buffer[1024];
+        int size;
+        while ((size = gzread(file, buffer, sizeof(buffer))) > 0) {
+            result.append(buffer, size);
+        }
+        gzclose(file);
+    }
+    return result;
+}
+
+TEST_F(FileTest, compress_rotated_files)
+{
+    std::string path = "test_logs/log_compress/";
+    std::filesystem::remove_all(path);
+    SetUp(path + "compress_%i.log");
+    file_sink->set_max_file_size(100);
+    ASSERT_TRUE(file_sink->set_compression(Compression::GZIP));
+
+    FakeRecordData record(LogLevel::INFO, std::string(60, 'y').c_str());
+    for (int i = 0; i < 3; ++i) {
+        file_sink->write(&record, nullptr);
+    }
+    file_sink->flush();
+
+    std::vector<std::string> names;
+    for (auto& p: std::filesystem::directory_iterator(path)) {
+        names.push_back(p.path().filename().string());
+    }
+    std::sort(names.begin(), names.end());
+    // compress_3.log is the next file created ahead of time
+    std::vector<std::string> expected_names{
+        "compress_0.log.gz", "compress_1.log.gz", "compress_2.log", "compress_3.log"
+    };
+    EXPECT_EQ(names, expected_names);
+    EXPECT_EQ(read_gzip_file(path + "compress_0.log.gz"), std::string(60, 'y') + "\n");
+
+    // compressed files keep their indexes
+    file_sink.reset();
+    SetUp(path + "compress_%i.log");
+    file_sink->set_max_file_size(100);
+    file_sink->write(&record, nullptr);
+    EXPECT_EQ(file_sink->get_filename(), path + "compress_2.log");
+
+    file_sink.reset();
+    std::filesystem::remove_all(path);
+    SetUp(file_template);
+}
+
+TEST_F(FileTest, compress_rotated_files_max_files)
+{
+    std::string path = "test_logs/log_compress_max/";
+    std::filesystem::remove_all(path);
+    std::filesystem::create_directories(path);
+    for (int i = 0; i < 5; ++i) {
+        std::ofstream(path + "compress_" + std::to_string(i) + ".log.gz") << "x";
+    }
+    std::ofstream(path + "compress_9.log.tmp") << "x";
+    SetUp(path + "compress_%i.log", 3);
+    file_sink->set_max_file_size(100);
+    file_sink->set_compression(Compression::GZIP);
+
+    FakeRecordData record(LogLevel::INFO, std::string(60, 'y').c_str());
+    for (int i = 0; i < 2; ++i) {
+        file_sink->write(&record, nullptr);
+    }
+    file_sink->flush();
+
+    std::vector<std::string> names;
+    for (auto& p: std::filesystem::directory_iterator(path)) {
+        names.push_back(p.path().filename().string());
+    }
+    std::sort(names.begin(), names.end());
+    // the temporary file doesn't match the template
+    std::vector<std::string> expected_names{
+        "compress_4.log.gz", "compress_5.log.gz", "compress_6.log",
+        "compress_7.log", "compress_9.log.tmp"
+    };
+    EXPECT_EQ(names, expected_names);
+
+    file_sink.reset();
+    std::filesystem::remove_all(path);
+    SetUp(file_template);
+}
+
+TEST_F(FileTest, compress_reused_file_names)
+{
+    std::string path = "test_logs/log_compress_reused/";
+    std::filesystem::remove_all(path);
+    std::filesystem::create_directories(path);
+    SetUp(path + "log_%H.log");
+    file_sink->set_compression(Compression::GZIP);
+
+    std::tm datetime;
+    local_datetime(&datetime, 1700000000);
+    datetime.tm_min = 0;
+    datetime.tm_sec = 0;
+    datetime.tm_hour += 1;
+    datetime.tm_isdst = -1;
+    int64_t boundary = static_cast<int64_t>(mktime(&datetime)) * 1000;
+    auto filename = [&path](int64_t time_ms) {
+        std::tm datetime;
+        local_datetime(&datetime, static_cast<time_t>(time_ms / 1000));
+        char name[16];
+        std::strftime(name, sizeof(name), "log_%H.log", &datetime);
+        return path + name;
+    };
+    std::string first_file = filename(boundary - 1000);
+    std::string second_file = filename(boundary + 1000);
+
+    // the archive of the same hour of a previous day
+    gzFile archive = gzopen((first_file + ".gz").c_str(), "wb");
+    ASSERT_TRUE(archive);
+    gzputs(archive, "old line\n");
+    gzclose(archive);
+
+    FakeRecordData record;
+    for (auto [offset, text] : std::vector<std::pair<int64_t, std::string>>{
+        {-1000, "first"}, {1000, "second"}, {-500, "late"}, {2000, "third"}})
+    {
+        record.milliseconds = boundary + offset;
+        record.data = text;
+        file_sink->write(&record, nullptr);
+    }
+    file_sink->flush();
+
+    // the archive is extended, the late record doesn't reopen the compressed file
+    EXPECT_EQ(read_gzip_file(first_file + ".gz"), "old line\nfirst\n");
+    EXPECT_FALSE(std::filesystem::exists(first_file));
+    EXPECT_EQ(read_file(second_file.c_str()), "second\nlate\nthird\n");
+    EXPECT_FALSE(std::filesystem::exists(second_file + ".gz"));
+
+    file_sink.reset();
+    std::filesystem::remove_all(path);
+    SetUp(file_template);
+}
+
+TEST_F(FileTest, stream_compression_frames)
+{
+    std::string filename = "test_logs/stream_test.log.gz";
+    std::remove(filename.c_str());
+    SetUp(filename);
+    ASSERT_TRUE(file_sink->set_stream_compression(Compression::GZIP));
+    FlushPolicy policy;
+    policy.buffer_size = 1024;
+    file_sink->set_flush_policy(policy);
+
+    std::string expected;
+    for (int i = 0; i < 10; ++i) {
+        std::string text = "line " + std::to_string(i);
+        FakeRecordData record(LogLevel::INFO, text.c_str());
+        file_sink->write(&record, nullptr);
+        expected += text + "\n";
+    }
+    file_sink->flush();
+    EXPECT_EQ(read_gzip_file(filename), expected);
+
+    // the reopened file is continued with a new frame
+    SetUp(filename);
+    file_sink->set_stream_compression(Compression::GZIP);
+    FakeRecordData record(LogLevel::INFO, "last line");
+    file_sink->write(&record, nullptr);
+    file_sink.reset();
+    EXPECT_EQ(read_gzip_file(filename), expected + "last line\n");
+
+    std::remove(filename.c_str());
+    SetUp(file_template);
+}
+
+TEST_F(FileTest, stream_compression_frame_size)
+{
+    std::string filename = "test_logs/stream_frame_test.log.gz";
+    std::remove(filename.c_str());
+    SetUp(filename);
+    // the default flush policy doesn't turn every record into a frame
+    ASSERT_TRUE(file_sink->set_stream_compression(Compression::GZIP));
+
+    std::string expected;
+    for (int i = 0; i < 10; ++i) {
+        std::string text = "line " + std::to_string(i);
+        FakeRecordData record(LogLevel::INFO, text.c_str());
+        file_sink->write(&record, nullptr);
+        expected += text + "\n";
+    }
+    std::error_code code;
+    EXPECT_EQ(std::filesystem::file_size(filename, code), 0u);
+
+    file_sink->flush();
+    EXPECT_EQ(read_gzip_file(filename), expected);
+
+    file_sink.reset();
+    std::remove(filename.c_str());
+    SetUp(file_template);
+}
+
+TEST_F(FileTest, stream_compression_max_file_size)
+{
+    std::string path = "test_logs/stream_size/";
+    std::filesystem::remove_all(path);
+    SetUp(path + "stream_%i.log.gz");
+    ASSERT_TRUE(file_sink->set_stream_compression(Compression::GZIP, 1024, 0));
+    file_sink->set_max_file_size(2000);
+
+    std::string expected;
+    uint64_t value = 1;
+    for (int i = 0; i < 300; ++i) {
+        // the text is hardly compressible
+        std::string text;
+        for (int j = 0; j < 4; ++j) {
+            value = value * 6364136223846793005ull + 1442695040888963407ull;
+            text += std::to_string(value);
+        }
+        FakeRecordData record(LogLevel::INFO, text.c_str());
+        file_sink->write(&record, nullptr);
+        expected += text + "\n";
+    }
+    file_sink.reset();
+
+    // the limit applies to the compressed size, a file is rotated after the frame that reaches it
+    std::string content;
+    int index = 0;
+    std::error_code code;
+    for (; std::filesystem::exists(path + "stream_" + std::to_string(index) + ".log.gz", code); ++index) {
+        std::string filename = path + "stream_" + std::to_string(index) + ".log.gz";
+        EXPECT_LT(std::filesystem::file_size(filename, code), 2000u + 1024u);
+        content += read_gzip_file(filename);
+    }
+    EXPECT_GT(index, 2);
+    EXPECT_EQ(content, expected);
+
+    std::filesystem::remove_all(path);
+    SetUp(file_template);
+}
+
+#ifdef __unix__
+TEST_F(FileTest, stream_compression_shared_mode)
+{
+    // frames of several processes could interleave
+    SetUp("test_logs/stream_shared_test.log.gz");
+    ASSERT_TRUE(file_sink->set_stream_compression(Compression::GZIP));
+    EXPECT_FALSE(file_sink->set_shared_mode(true));
+
+    EXPECT_TRUE(file_sink->set_stream_compression(Compression::NONE));
+    EXPECT_TRUE(file_sink->set_shared_mode(true));
+    EXPECT_FALSE(file_sink->set_stream_compression(Compression::GZIP));
+    EXPECT_TRUE(file_sink->set_stream_compression(Compression::NONE));
+
+    SetUp(file_template);
+}
+#endif
+
+#endif
@@ -0,0 +1,105 @@
+#include "gtest/gtest.h"
+#include <logging/sink/filter.h>
+#include <logging/log_level.h>
+#include <string>
+#include <vector>
+#include "fake_record_data.h"
+
+using namespace logging;
+
+/**
+ * @brief Sink that keeps messages of written records.
+ * 
+ */
+struct CaptureSink : public ILogSink
+{
+    std::vector<std::string> records;
+
+    virtual void write(ILogRecordData *record, IFormatter *) override
+    {
+        records.push_back(record->get_data());
+    }
+};
+
+/*
+ *
+ *  FilterSink tests
+ * 
+ */
+
+TEST(FilterSinkTest, level)
+{
+    CaptureSink target;
+    FilterSink sink{&target, "level >= WARNING"};
+    FakeRecordData info{LogLevel::INFO, "info"};
+    FakeRecordData warning{LogLevel::WARNING, "warning"};
+    FakeRecordData error{LogLevel::ERROR, "error"};
+
+    sink.write(&info, nullptr);
+    sink.write(&warning, nullptr);
+    sink.write(&error, nullptr);
+
+    std::vector<std::string> expected{"warning", "error"};
+    EXPECT_EQ(target.records, expected);
+}
+
+TEST(FilterSinkTest, level_range)
+{
+    CaptureSink target;
+    FilterSink sink{&target, "level > debug && level < 40"};
+    FakeRecordData debug{LogLevel::DEBUG, "debug"};
+    FakeRecordData info{LogLevel::INFO, "info"};
+    FakeRecordData error{LogLevel::ERROR, "error"};
+
+    EXPECT_FALSE(sink.matches(&debug));
+    EXPECT_TRUE(sink.matches(&info));
+    EXPECT_FALSE(sink.matches(&error));
+}
+
+TEST(FilterSinkTest, text)
+{
+    CaptureSink target;
+    FilterSink sink{&target,
+        "level >= ERROR or (file starts_with \"src/net/\" and not message contains \"heartbeat\")"};
+
+    FakeRecordData net{LogLevel::INFO, "connection timeout", "src/net/socket.cpp", 10};
+    FakeRecordData heartbeat{LogLevel::INFO, "heartbeat sent", "src/net/socket.cpp", 20};
+    FakeRecordData other{LogLevel::INFO, "connection timeout", "src/db/query.cpp", 30};
+    FakeRecordData error{LogLevel::ERROR, "heartbeat failed", "src/db/query.cpp", 40};
+
+    EXPECT_TRUE(sink.matches(&net));
+    EXPECT_FALSE(sink.matches(&heartbeat));
+    EXPECT_FALSE(sink.matches(&other));
+    EXPECT_TRUE(sink.matches(&error));
+}
+
+TEST(FilterSinkTest, text_compare)
+{
+    CaptureSink target;
+    FakeRecordData record{LogLevel::INFO, "disk \"data\" is full", "src/storage.cpp", 42};
+
+    EXPECT_TRUE(FilterSink(&target, "file == \"src/storage.cpp\"").matches(&record));
+    EXPECT_TRUE(FilterSink(&target, "file != \"storage.cpp\"").matches(&record));
+    EXPECT_TRUE(FilterSink(&target, "file ends_with \"storage.cpp\"").matches(&record));
+    EXPECT_TRUE(FilterSink(&target, "message contains \"\\\"data\\\"\"").matches(&record));
+    EXPECT_TRUE(FilterSink(&target, "message contains \"full\"").matches(&record));
+    EXPECT_FALSE(FilterSink(&target, "message contains \"fully\"").matches(&record));
+    EXPECT_TRUE(FilterSink(&target, "message starts_with \"disk\"").matches(&record));
+    EXPECT_TRUE(FilterSink(&target, "line == 42 && !(line < 10 || line > 100)").matches(&record));
+}
+
+TEST(FilterSinkTest, errors)
+{
+    CaptureSink target;
+    for (auto expression : {
+        "", "level", "level >=", "level >= SEVERE", "file < \"a\"", "message contains 1",
+        "(level > INFO", "level > INFO)", "size > 1", "message contains \"a", "level > INFO @"})
+    {
+        try {
+            FilterSink sink{&target, expression};
+            FAIL() << expression;
+        } catch (FilterException&) {
+            SUCCEED();
+        }
+    }
+}
@@ -3,6 +3,13 @@
 #include <logging/log_level.h>
 #include "fake_record_data.h"
 #include <logging/helper/datetime.h>
+#include <cstdlib>
+#ifdef __unix__
+#include <unistd.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
 
 using namespace logging;
 
@@ -305,3 +312,85 @@ TEST(LogFormatterTest, move_format)
     EXPECT_EQ(line2, "[WARNING] test.cpp 1234: test");
     EXPECT_EQ(line3, "[WARNING]: test");
 }
+
+TEST(LogFormatterTest, format_constants)
+{
+#ifdef __unix__
+    setenv("LOGGING_TEST_ENV", "env_value", 1);
+    unsetenv("LOGGING_TEST_NO_ENV");
+#else
+    _putenv_s("LOGGING_TEST_ENV", "env_value");
+    _putenv_s("LOGGING_TEST_NO_ENV", "");
+#endif
+    Formatter::set_constant("app", "test_app");
+    Formatter fmt("${app} ${pid} ${env:LOGGING_TEST_ENV}${env:LOGGING_TEST_NO_ENV}: ${message}");
+    FakeRecordData rec{LogLevel::INFO, "test"};
+
+    EXPECT_EQ(fmt.format_record(&rec), "test_app " + std::to_string(getpid()) + " env_value: test");
+}
+
+TEST(LogFormatterTest, format_constants_resolved_once)
+{
+    Formatter::set_constant("service", "first");
+    Formatter fmt("[${service}] ${message}");
+    Formatter::set_constant("service", "second");
+    FakeRecordData rec{LogLevel::INFO, "test"};
+
+    EXPECT_EQ(fmt.format_record(&rec), "[first] test");
+
+    fmt.set_format("[${service}] ${message}");
+    EXPECT_EQ(fmt.format_record(&rec), "[second] test");
+}
+
+#ifdef __unix__
+TEST(LogFormatterTest, format_hostname)
+{
+    char name[256] = {0};
+    gethostname(name, sizeof(name) - 1);
+    Formatter fmt("${hostname} ${message}");
+    FakeRecordData rec{LogLevel::INFO, "test"};
+
+    EXPECT_EQ(fmt.format_record(&rec), std::string(name) + " test");
+}
+#endif
+
+TEST(LogFormatterTest, format_width_align)
+{
+    Formatter fmt("[${level_name:<8}|${level_name:>8}|${level_name:*^9}|${line:5}|${line:<5}] ${message}");
+    FakeRecordData rec{LogLevel::INFO, "test", "test.cpp", 134};
+
+    EXPECT_EQ(fmt.format_record(&rec), "[INFO    |    INFO|**INFO***|  134|134  ] test");
+}
+
+TEST(LogFormatterTest, format_truncate)
+{
+    Formatter fmt("${message:.4}|${file:.4}|${message:-^8.2}");
+    FakeRecordData rec{LogLevel::INFO, "test message", "test.cpp", 134};
+
+    EXPECT_EQ(fmt.format_record(&rec), "test|test|---te---");
+}
+
+TEST(LogFormatterTest, format_truncate_utf8)
+{
+    Formatter fmt("${message:.3}|${message:_<8.5}");
+    FakeRecordData rec{LogLevel::INFO, u8"Привет мир"};
+
+    EXPECT_EQ(fmt.format_record(&rec), std::string(u8"При|Приве___"));
+}
+
+TEST(LogFormatterTest, format_wrong_spec)
+{
+    Formatter fmt("${level_name:abc}|${level_name:<8x}|${message:.}");
+    FakeRecordData rec{LogLevel::INFO, "test"};
+
+    EXPECT_EQ(fmt.format_record(&rec), "INFO|INFO|test");
+}
+
+TEST(LogFormatterTest, format_constant_spec)
+{
+    Formatter::set_constant("component", "net");
+    Formatter fmt("[${component:>6}][${env:LOGGING_TEST_NO_ENV:.<3}] ${message}");
+    FakeRecordData rec{LogLevel::INFO, "test"};
+
+    EXPECT_EQ(fmt.format_record(&rec), "[   net][...] test");
+}
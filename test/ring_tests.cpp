@@ -0,0 +1,130 @@
+#include "gtest/gtest.h"
+#include <logging/sink/ring.h>
+#include <logging/log_level.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "fake_record_data.h"
+
+using namespace logging;
+
+/*
+ *
+ *  RingSink tests
+ * 
+ */
+
+TEST(RingSinkTest, empty)
+{
+    RingSink sink{4096};
+    EXPECT_EQ(sink.capacity(), 4096u);
+    EXPECT_TRUE(sink.snapshot().empty());
+}
+
+TEST(RingSinkTest, records)
+{
+    RingSink sink{"[${level_name}] ${message}", 4096};
+    FakeRecordData rec1{LogLevel::INFO, "message 1", "", 0, 1000};
+    FakeRecordData rec2{LogLevel::ERROR, "message 2", "", 0, 2000};
+
+    sink.write(&rec1, nullptr);
+    sink.write(&rec2, nullptr);
+
+    auto records = sink.snapshot();
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records[0].text, "[INFO] message 1");
+    EXPECT_EQ(records[0].level, LogLevel::INFO);
+    EXPECT_EQ(records[0].time, 1000);
+    EXPECT_EQ(records[1].text, "[ERROR] message 2");
+    EXPECT_EQ(records[1].level, LogLevel::ERROR);
+    EXPECT_EQ(records[1].time, 2000);
+}
+
+TEST(RingSinkTest, query)
+{
+    RingSink sink{4096};
+    for (int i = 0; i < 10; ++i) {
+        std::string text = "message " + std::to_string(i);
+        FakeRecordData rec{i % 2 ? LogLevel::WARNING : LogLevel::DEBUG, text.c_str(), "", 0, i * 1000};
+        sink.write(&rec, nullptr);
+    }
+
+    RingQuery query;
+    query.min_level = LogLevel::WARNING;
+    query.from_ms = 2000;
+    query.to_ms = 8000;
+    auto records = sink.snapshot(query);
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0].text, "message 3");
+    EXPECT_EQ(records[2].text, "message 7");
+
+    query.max_records = 2;
+    records = sink.snapshot(query);
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records[0].text, "message 5");
+    EXPECT_EQ(records[1].text, "message 7");
+}
+
+TEST(RingSinkTest, overwrite_oldest)
+{
+    RingSink sink{1024};
+    for (int i = 0; i < 1000; ++i) {
+        std::string text = "message " + std::to_string(i);
+        FakeRecordData rec{LogLevel::INFO, text.c_str()};
+        sink.write(&rec, nullptr);
+    }
+
+    auto records = sink.snapshot();
+    ASSERT_FALSE(records.empty());
+    EXPECT_LT(records.size(), 1000u);
+    EXPECT_EQ(records.back().text, "message 999");
+    int first = 1000 - static_cast<int>(records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        EXPECT_EQ(records[i].text, "message " + std::to_string(first + i));
+    }
+}
+
+TEST(RingSinkTest, truncate_large_record)
+{
+    RingSink sink{1024};
+    std::string text(1000, 'x');
+    FakeRecordData rec{LogLevel::INFO, text.c_str()};
+    sink.write(&rec, nullptr);
+
+    auto records = sink.snapshot();
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(records[0].text, std::string(256 - 32, 'x'));
+}
+
+TEST(RingSinkTest, concurrent_snapshot)
+{
+    RingSink sink{16 * 1024};
+    std::atomic<bool> done{false};
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([&sink, t]() {
+            for (int i = 0; i < 20000; ++i) {
+                std::string text(10 + i % 50, static_cast<char>('a' + t));
+                FakeRecordData rec{LogLevel::INFO, text.c_str()};
+                sink.write(&rec, nullptr);
+            }
+        });
+    }
+    std::thread reader([&]() {
+        while (!done) {
+            for (auto &record : sink.snapshot()) {
+                // a record is never torn
+                ASSERT_GE(record.text.length(), 10u);
+                ASSERT_EQ(record.text, std::string(record.text.length(), record.text[0]));
+            }
+        }
+    });
+
+    for (auto &writer : writers) {
+        writer.join();
+    }
+    done = true;
+    reader.join();
+    EXPECT_FALSE(sink.snapshot().empty());
+}
@@ -0,0 +1,157 @@
+#include "gtest/gtest.h"
+#include <logging/sink/shm_ring.h>
+#include <logging/log_level.h>
+#include "fake_record_data.h"
+
+#ifdef __unix__
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace logging;
+
+/*
+ *
+ *  ShmRingSink tests
+ * 
+ */
+
+class ShmRingTest : public ::testing::Test
+{
+protected:
+
+    void SetUp() override 
+    {
+        name = "/logging_test_" + std::to_string(getpid());
+        ShmRingReader::remove(name);
+    }
+
+    void TearDown() override
+    {
+        ShmRingReader::remove(name);
+    }
+
+    std::string name;
+};
+
+TEST_F(ShmRingTest, write_and_collect)
+{
+    ShmRingSink sink{"[${level_name}] ${message}", name, 4096};
+    ASSERT_TRUE(sink.is_open());
+    FakeRecordData rec1{LogLevel::INFO, "message 1", "", 0, 1000};
+    FakeRecordData rec2{LogLevel::ERROR, "message 2", "", 0, 2000};
+    sink.write(&rec1, nullptr);
+    sink.write(&rec2, nullptr);
+
+    ShmRingReader reader{name};
+    ASSERT_TRUE(reader.is_open());
+    std::vector<RingRecord> records;
+    EXPECT_EQ(reader.read(records), 2u);
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records[0].text, "[INFO] message 1");
+    EXPECT_EQ(records[0].time, 1000);
+    EXPECT_EQ(records[1].text, "[ERROR] message 2");
+    EXPECT_EQ(records[1].level, LogLevel::ERROR);
+
+    // already collected records aren't read again
+    EXPECT_EQ(reader.read(records), 0u);
+}
+
+TEST_F(ShmRingTest, shared_by_sinks)
+{
+    ShmRingSink sink1{name, 4096};
+    // the capacity of the existing ring is kept
+    ShmRingSink sink2{name, 1024};
+    ASSERT_TRUE(sink2.is_open());
+    FakeRecordData rec1{LogLevel::INFO, "message 1"};
+    FakeRecordData rec2{LogLevel::INFO, "message 2"};
+    sink1.write(&rec1, nullptr);
+    sink2.write(&rec2, nullptr);
+
+    std::vector<RingRecord> records;
+    ShmRingReader{name}.read(records);
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records[0].text, "message 1");
+    EXPECT_EQ(records[1].text, "message 2");
+}
+
+TEST_F(ShmRingTest, restarted_collector)
+{
+    ShmRingSink sink{name, 4096};
+    FakeRecordData rec1{LogLevel::INFO, "message 1"};
+    FakeRecordData rec2{LogLevel::INFO, "message 2"};
+    std::vector<RingRecord> records;
+
+    sink.write(&rec1, nullptr);
+    ShmRingReader{name}.read(records);
+    sink.write(&rec2, nullptr);
+    ShmRingReader{name}.read(records);
+
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records[1].text, "message 2");
+}
+
+TEST_F(ShmRingTest, overrun)
+{
+    ShmRingSink sink{name, 1024};
+    ShmRingReader reader{name};
+    for (int i = 0; i < 100; ++i) {
+        std::string text = "message " + std::to_string(i);
+        FakeRecordData rec{LogLevel::INFO, text.c_str()};
+        sink.write(&rec, nullptr);
+    }
+
+    std::vector<RingRecord> records;
+    reader.read(records);
+    ASSERT_FALSE(records.empty());
+    EXPECT_EQ(records.back().text, "message 99");
+    EXPECT_GT(reader.get_lost_bytes(), 0u);
+    EXPECT_EQ(sink.get_lost_bytes(), reader.get_lost_bytes());
+}
+
+TEST_F(ShmRingTest, lapped_writer)
+{
+    ShmRingSink sink{name, 4096};
+    ShmRingReader reader{name};
+    std::string text(64, 'a');
+    FakeRecordData rec1{LogLevel::INFO, text.c_str()};
+    sink.write(&rec1, nullptr);
+
+    // a writer that reserved this space one lap earlier and was preempted
+    // stores its text into the committed record without moving the head
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    ASSERT_GE(fd, 0);
+    struct stat st;
+    ASSERT_EQ(fstat(fd, &st), 0);
+    size_t size = static_cast<size_t>(st.st_size);
+    void *region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    ASSERT_NE(region, MAP_FAILED);
+    // the data of the ring is at the end of the region, the record's text starts at its 5th word
+    char *data = static_cast<char*>(region) + size - 4096;
+    memcpy(data + 48, "bbbbbbbb", 8);
+    munmap(region, size);
+
+    FakeRecordData rec2{LogLevel::INFO, "message 2"};
+    sink.write(&rec2, nullptr);
+
+    std::vector<RingRecord> records;
+    reader.read(records);
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(records[0].text, "message 2");
+    EXPECT_GT(reader.get_lost_bytes(), 0u);
+}
+
+TEST_F(ShmRingTest, no_ring)
+{
+    ShmRingReader reader{name};
+    EXPECT_FALSE(reader.is_open());
+}
+
+#endif
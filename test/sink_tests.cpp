@@ -1,8 +1,16 @@
 #include "gtest/gtest.h"
 #include <iostream>
 #include <logging/sink/cout.h>
+#include <logging/sink/console.h>
+#include <fstream>
+#include <thread>
+#include <vector>
 #include <logging/log_level.h>
 #include "fake_record_data.h"
+#ifdef __unix__
+#include <unistd.h>
+#include <fcntl.h>
+#endif
 
 using namespace logging;
 
@@ -120,4 +128,109 @@ TEST_F(CoutSinkTest, logger_formatter)
     sink.write(&rec1, &fmt);
 
     EXPECT_EQ(fetch_output(), expected_output);
-}
\ No newline at end of file
+}
+
+#ifdef __unix__
+
+/*
+ *
+ *  ConsoleSink tests
+ * 
+ */
+
+class ConsoleSinkTest : public ::testing::Test
+{
+protected:
+
+    void SetUp() override 
+    {
+        // redirect stderr to a file
+        std::fflush(stderr);
+        saved_fd = dup(2);
+        int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        dup2(fd, 2);
+        close(fd);
+    }
+
+    void TearDown() override
+    {
+        dup2(saved_fd, 2);
+        close(saved_fd);
+        std::remove(filename);
+    }
+
+    std::string fetch_output()
+    {
+        std::ifstream file(filename, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    const char *filename = "console_sink_test.log";
+    int saved_fd;
+};
+
+TEST_F(ConsoleSinkTest, batched_messages)
+{
+    ConsoleSink sink{ConsoleStream::STDERR};
+    sink.set_flush_policy({1024, 0, LogLevel::ERROR});
+    FakeRecordData rec1{LogLevel::INFO, "message 1"};
+    FakeRecordData rec2{LogLevel::INFO, "message 2"};
+
+    sink.write(&rec1, nullptr);
+    sink.write(&rec2, nullptr);
+    EXPECT_EQ(fetch_output(), "");
+
+    sink.flush();
+    EXPECT_EQ(fetch_output(), "message 1\nmessage 2\n");
+}
+
+TEST_F(ConsoleSinkTest, flush_level)
+{
+    ConsoleSink sink{"[${level_name}] ${message}", ConsoleStream::STDERR};
+    sink.set_flush_policy({1024, 0, LogLevel::ERROR});
+    FakeRecordData rec1{LogLevel::INFO, "message 1"};
+    FakeRecordData rec2{LogLevel::ERROR, "message 2"};
+
+    sink.write(&rec1, nullptr);
+    sink.write(&rec2, nullptr);
+    EXPECT_EQ(fetch_output(), "[INFO] message 1\n[ERROR] message 2\n");
+}
+
+TEST_F(ConsoleSinkTest, unbuffered)
+{
+    ConsoleSink sink{ConsoleStream::STDERR};
+    sink.set_flush_policy({});
+    FakeRecordData rec{LogLevel::INFO, "message"};
+
+    sink.write(&rec, nullptr);
+    EXPECT_EQ(fetch_output(), "message\n");
+}
+
+TEST_F(ConsoleSinkTest, whole_lines_from_threads)
+{
+    {
+        ConsoleSink sink{ConsoleStream::STDERR};
+        sink.set_flush_policy({100, 0, LogLevel::ERROR});
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&sink, t]() {
+                std::string text(50, static_cast<char>('a' + t));
+                FakeRecordData rec{LogLevel::INFO, text.c_str()};
+                for (int i = 0; i < 100; ++i) {
+                    sink.write(&rec, nullptr);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+
+    std::string output = fetch_output();
+    ASSERT_EQ(output.length(), 400u * 51);
+    for (size_t pos = 0; pos < output.length(); pos += 51) {
+        EXPECT_EQ(output.substr(pos, 51), std::string(50, output[pos]) + "\n");
+    }
+}
+
+#endif
@@ -0,0 +1,133 @@
+#include "gtest/gtest.h"
+#include <logging/sink/syslog.h>
+#include <logging/log_level.h>
+#include "fake_record_data.h"
+
+#ifdef __linux__
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace logging;
+
+/*
+ *
+ *  SyslogSink tests
+ * 
+ */
+
+class SyslogSinkTest : public ::testing::Test
+{
+protected:
+
+    void SetUp() override 
+    {
+        // socket stand-in of the syslog daemon
+        std::remove(socket_path);
+        fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, socket_path);
+        ASSERT_EQ(bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)), 0);
+    }
+
+    void TearDown() override
+    {
+        close(fd);
+        std::remove(socket_path);
+    }
+
+    std::vector<std::string> receive()
+    {
+        std::vector<std::string> result;
+        char buffer[65536];
+        ssize_t size;
+        while ((size = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)) >= 0) {
+            result.emplace_back(buffer, size);
+        }
+        return result;
+    }
+
+    const char *socket_path = "syslog_test.sock";
+    int fd;
+};
+
+TEST_F(SyslogSinkTest, rfc5424_messages)
+{
+    SyslogSink sink{SyslogProtocol::RFC5424, "test_app", socket_path};
+    FakeRecordData rec1{LogLevel::INFO, "message 1"};
+    FakeRecordData rec2{LogLevel::ERROR, "message 2"};
+
+    sink.write(&rec1, nullptr);
+    // the batch is sent on the error record
+    sink.write(&rec2, nullptr);
+
+    auto messages = receive();
+    ASSERT_EQ(messages.size(), 2u);
+    std::string header = "1 2021-01-12T14:46:41.012Z ";
+    std::string tail = " test_app " + std::to_string(getpid()) + " - - ";
+    EXPECT_EQ(messages[0].substr(0, 4 + header.length()), "<14>" + header);
+    EXPECT_EQ(messages[0].substr(messages[0].length() - tail.length() - 9), tail + "message 1");
+    EXPECT_EQ(messages[1].substr(0, 4), "<11>");
+    EXPECT_EQ(sink.get_dropped_count(), 0u);
+}
+
+TEST_F(SyslogSinkTest, journald_fields)
+{
+    SyslogSink sink{"[${level_name}] ${message}", SyslogProtocol::JOURNALD, "test_app", socket_path};
+    sink.set_facility(3);
+    FakeRecordData rec1{LogLevel::WARNING, "message", "main.cpp", 10};
+    FakeRecordData rec2{LogLevel::DEBUG, "line 1\nline 2"};
+
+    sink.write(&rec1, nullptr);
+    sink.write(&rec2, nullptr);
+    sink.flush();
+
+    auto messages = receive();
+    ASSERT_EQ(messages.size(), 2u);
+    EXPECT_EQ(messages[0],
+        "PRIORITY=4\nSYSLOG_FACILITY=3\nSYSLOG_IDENTIFIER=test_app\n"
+        "CODE_FILE=main.cpp\nCODE_LINE=10\nMESSAGE=[WARNING] message\n");
+    std::string text = "[DEBUG] line 1\nline 2";
+    std::string length{static_cast<char>(text.length()), 0, 0, 0, 0, 0, 0, 0};
+    EXPECT_EQ(messages[1],
+        "PRIORITY=7\nSYSLOG_FACILITY=3\nSYSLOG_IDENTIFIER=test_app\n"
+        "MESSAGE\n" + length + text + "\n");
+}
+
+TEST_F(SyslogSinkTest, drop_when_full)
+{
+    SyslogSink sink{SyslogProtocol::RFC5424, "test_app", socket_path};
+    sink.set_flush_policy({64 * 1024, 0, LogLevel::ERROR});
+    std::string text(1000, 'x');
+    FakeRecordData rec{LogLevel::INFO, text.c_str()};
+
+    // nothing is read, so the socket buffer gets full
+    const uint64_t count = 5000;
+    for (uint64_t i = 0; i < count; ++i) {
+        sink.write(&rec, nullptr);
+    }
+    sink.flush();
+
+    auto received = receive().size();
+    EXPECT_GT(sink.get_dropped_count(), 0u);
+    EXPECT_EQ(received + sink.get_dropped_count(), count);
+}
+
+TEST_F(SyslogSinkTest, no_daemon)
+{
+    SyslogSink sink{SyslogProtocol::RFC5424, "test_app", "no_syslog_test.sock"};
+    FakeRecordData rec{LogLevel::INFO, "message"};
+
+    sink.write(&rec, nullptr);
+    sink.flush();
+    EXPECT_EQ(sink.get_dropped_count(), 1u);
+}
+
+#endif
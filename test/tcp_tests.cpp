@@ -0,0 +1,191 @@
+#include "gtest/gtest.h"
+#include <logging/sink/tcp.h>
+#include <logging/log_level.h>
+#include "fake_record_data.h"
+
+#ifdef __unix__
+
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using namespace logging;
+
+/*
+ *
+ *  TcpSink tests
+ * 
+ */
+
+class TcpSinkTest : public ::testing::Test
+{
+protected:
+
+    void SetUp() override 
+    {
+        listen_fd = -1;
+        client_fd = -1;
+        start_listener(0);
+    }
+
+    void TearDown() override
+    {
+        stop_listener();
+    }
+
+    void start_listener(uint16_t listen_port)
+    {
+        listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        int flag = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(listen_port);
+        ASSERT_EQ(bind(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)), 0);
+        ASSERT_EQ(listen(listen_fd, 4), 0);
+        socklen_t length = sizeof(addr);
+        getsockname(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), &length);
+        port = ntohs(addr.sin_port);
+    }
+
+    void stop_listener()
+    {
+        if (client_fd >= 0) {
+            close(client_fd);
+            client_fd = -1;
+        }
+        if (listen_fd >= 0) {
+            close(listen_fd);
+            listen_fd = -1;
+        }
+    }
+
+    /**
+     * @brief Accepts the connection of the sink and reads size bytes.
+     */
+    std::string receive(size_t size)
+    {
+        if (client_fd < 0) {
+            struct pollfd pfd = {listen_fd, POLLIN, 0};
+            if (poll(&pfd, 1, 5000) <= 0) {
+                return "";
+            }
+            client_fd = accept(listen_fd, nullptr, nullptr);
+        }
+        std::string result;
+        char buffer[4096];
+        while (result.length() < size) {
+            struct pollfd pfd = {client_fd, POLLIN, 0};
+            if (poll(&pfd, 1, 5000) <= 0) {
+                break;
+            }
+            ssize_t res = recv(client_fd, buffer, std::min(sizeof(buffer), size - result.length()), 0);
+            if (res <= 0) {
+                break;
+            }
+            result.append(buffer, res);
+        }
+        return result;
+    }
+
+    int listen_fd;
+    int client_fd;
+    uint16_t port;
+};
+
+TEST_F(TcpSinkTest, newline_framing)
+{
+    TcpSink sink{"127.0.0.1", port};
+    FakeRecordData rec1{LogLevel::INFO, "message 1"};
+    FakeRecordData rec2{LogLevel::INFO, "message 2"};
+
+    sink.write(&rec1, nullptr);
+    sink.write(&rec2, nullptr);
+
+    std::string expected = "message 1\nmessage 2\n";
+    EXPECT_EQ(receive(expected.length()), expected);
+    EXPECT_TRUE(sink.flush(1000));
+    EXPECT_TRUE(sink.is_connected());
+}
+
+TEST_F(TcpSinkTest, length_prefix_framing)
+{
+    TcpSink sink{"[${level_name}] ${message}", "localhost", port, TcpFraming::LENGTH_PREFIX};
+    FakeRecordData rec{LogLevel::ERROR, "message"};
+
+    sink.write(&rec, nullptr);
+
+    std::string text = "[ERROR] message";
+    std::string expected = std::string{0, 0, 0, static_cast<char>(text.length())} + text;
+    EXPECT_EQ(receive(expected.length()), expected);
+}
+
+TEST_F(TcpSinkTest, large_batch)
+{
+    std::string expected;
+    {
+        TcpSink sink{"127.0.0.1", port};
+        std::string text(100, 'x');
+        FakeRecordData rec{LogLevel::INFO, text.c_str()};
+        for (int i = 0; i < 10000; ++i) {
+            sink.write(&rec, nullptr);
+            expected += text + "\n";
+        }
+        std::thread reader([&]() { EXPECT_EQ(receive(expected.length()), expected); });
+        EXPECT_TRUE(sink.flush(5000));
+        reader.join();
+        EXPECT_EQ(sink.get_dropped_count(), 0u);
+    }
+}
+
+TEST_F(TcpSinkTest, drop_when_disconnected)
+{
+    uint16_t free_port = port;
+    stop_listener();
+
+    TcpSink sink{"127.0.0.1", free_port};
+    sink.set_buffer_limit(100, DropPolicy::DROP_NEWEST);
+    FakeRecordData rec{LogLevel::INFO, std::string(29, 'x').c_str()};
+    for (int i = 0; i < 5; ++i) {
+        sink.write(&rec, nullptr);
+    }
+    EXPECT_EQ(sink.get_dropped_count(), 2u);
+    EXPECT_FALSE(sink.is_connected());
+    EXPECT_FALSE(sink.flush(10));
+}
+
+TEST_F(TcpSinkTest, drop_oldest_and_reconnect)
+{
+    uint16_t free_port = port;
+    stop_listener();
+
+    TcpSink sink{"127.0.0.1", free_port};
+    sink.set_buffer_limit(30, DropPolicy::DROP_OLDEST);
+    sink.set_reconnect_delay(10, 20);
+    FakeRecordData rec1{LogLevel::INFO, "message 1"};
+    FakeRecordData rec2{LogLevel::INFO, "message 2"};
+    FakeRecordData rec3{LogLevel::INFO, "message 3"};
+    FakeRecordData rec4{LogLevel::INFO, "message 4"};
+    sink.write(&rec1, nullptr);
+    sink.write(&rec2, nullptr);
+    sink.write(&rec3, nullptr);
+    sink.write(&rec4, nullptr);
+    EXPECT_EQ(sink.get_dropped_count(), 1u);
+
+    // the collector is started later
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    start_listener(free_port);
+    std::string expected = "message 2\nmessage 3\nmessage 4\n";
+    EXPECT_EQ(receive(expected.length()), expected);
+    EXPECT_TRUE(sink.flush(1000));
+}
+
+#endif
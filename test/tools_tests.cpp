@@ -0,0 +1,175 @@
+#include "gtest/gtest.h"
+#include <logging/sink/shm_ring.h>
+#include <logging/log_level.h>
+#include "fake_record_data.h"
+
+#ifdef __unix__
+
+#include <string>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+using namespace logging;
+
+/*
+ *
+ *  Tools tests, the tools are run as the processes
+ * 
+ */
+
+class ToolsTest : public ::testing::Test
+{
+protected:
+
+    void SetUp() override 
+    {
+        dir = std::filesystem::temp_directory_path() / ("logging_tools_test_" + std::to_string(getpid()));
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::string path(const char *filename) const
+    {
+        return (dir / filename).string();
+    }
+
+    void write_file(const std::string &filename, const std::string &data)
+    {
+        std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+        file << data;
+    }
+
+    std::string read_file(const std::string &filename)
+    {
+        std::ifstream file(filename, std::ios::in | std::ios::binary);
+        std::stringstream data;
+        data << file.rdbuf();
+        return data.str();
+    }
+
+    std::filesystem::path dir;
+};
+
+TEST_F(ToolsTest, log_merge)
+{
+    write_file(path("app_1.log"),
+        "2024-01-01 00:00:01.500 [INFO] a1\n"
+        "  continuation of a1\n"
+        "2024-01-01 00:00:03 [INFO] a2\n");
+    write_file(path("app_2.log"),
+        "2024-01-01 00:00:01.25 [INFO] b1\n"
+        "2024-01-01 00:00:03 [INFO] b2\n"
+        "2024-01-02 00:00:00,000001 [INFO] b3\n");
+
+    std::string command = std::string(LOG_MERGE_PATH)
+        + " -o " + path("merged.log") + " " + path("app_1.log") + " " + path("app_2.log");
+    ASSERT_EQ(std::system(command.c_str()), 0);
+
+    // the records of the same time keep the order of the files
+    EXPECT_EQ(read_file(path("merged.log")),
+        "2024-01-01 00:00:01.25 [INFO] b1\n"
+        "2024-01-01 00:00:01.500 [INFO] a1\n"
+        "  continuation of a1\n"
+        "2024-01-01 00:00:03 [INFO] a2\n"
+        "2024-01-01 00:00:03 [INFO] b2\n"
+        "2024-01-02 00:00:00,000001 [INFO] b3\n");
+}
+
+TEST_F(ToolsTest, log_merge_time_format)
+{
+    write_file(path("app_1.log"), "[01/Jan/2024:10:00:02] a1\n");
+    write_file(path("app_2.log"), "[01/Jan/2024:10:00:01] b1\n");
+
+    std::string command = std::string(LOG_MERGE_PATH)
+        + " -t '[%d/%b/%Y:%H:%M:%S]' -o " + path("merged.log") + " " + path("app_1.log") + " " + path("app_2.log");
+    ASSERT_EQ(std::system(command.c_str()), 0);
+    EXPECT_EQ(read_file(path("merged.log")), "[01/Jan/2024:10:00:01] b1\n[01/Jan/2024:10:00:02] a1\n");
+
+    command = std::string(LOG_MERGE_PATH) + " " + path("missing.log") + " 2> /dev/null";
+    EXPECT_NE(std::system(command.c_str()), 0);
+}
+
+TEST_F(ToolsTest, shm_collector)
+{
+    std::string name1 = "/logging_tools_test_1_" + std::to_string(getpid());
+    std::string name2 = "/logging_tools_test_2_" + std::to_string(getpid());
+    {
+        ShmRingSink sink1{name1, 4096};
+        ShmRingSink sink2{name2, 4096};
+        ASSERT_TRUE(sink1.is_open());
+        ASSERT_TRUE(sink2.is_open());
+
+        std::string text(64, 'a');
+        FakeRecordData rec1{LogLevel::INFO, text.c_str(), "", 0, 1000};
+        sink1.write(&rec1, nullptr);
+
+        // a lapped writer tears the first record, the collector drops it
+        int fd = shm_open(name1.c_str(), O_RDWR, 0);
+        ASSERT_GE(fd, 0);
+        struct stat st;
+        ASSERT_EQ(fstat(fd, &st), 0);
+        size_t size = static_cast<size_t>(st.st_size);
+        void *region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        ASSERT_NE(region, MAP_FAILED);
+        char *data = static_cast<char*>(region) + size - 4096;
+        memcpy(data + 48, "bbbbbbbb", 8);
+        munmap(region, size);
+
+        FakeRecordData rec2{LogLevel::INFO, "ring 1 message", "", 0, 3000};
+        sink1.write(&rec2, nullptr);
+        FakeRecordData rec3{LogLevel::ERROR, "ring 2 message", "", 0, 2000};
+        sink2.write(&rec3, nullptr);
+    }
+
+    std::string output = path("collected.log");
+    std::string errors = path("collector.err");
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        int fd = ::open(errors.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        dup2(fd, STDERR_FILENO);
+        execl(SHM_COLLECTOR_PATH, SHM_COLLECTOR_PATH, "-i", "10", "-u",
+            output.c_str(), name1.c_str(), name2.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    // the records are flushed by the interval, the collector is stopped by a signal then
+    std::string expected = "ring 2 message\nring 1 message\n";
+    for (int i = 0; i < 500 && read_file(output) != expected; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    kill(pid, SIGTERM);
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+
+    // the records of the rings are merged by time
+    EXPECT_EQ(read_file(output), expected);
+    EXPECT_NE(read_file(errors).find("Ring " + name1 + " overrun"), std::string::npos);
+
+    // -u removed the rings
+    ShmRingReader reader{name1};
+    EXPECT_FALSE(reader.is_open());
+    ShmRingReader::remove(name1);
+    ShmRingReader::remove(name2);
+}
+
+#endif
@@ -0,0 +1,187 @@
+/*
+ * Merges log files written by threads (FileSink with %t in the template)
+ * into a single stream ordered by the time of the records:
+ *
+ *   log_merge [-t time_format] [-o output] file...
+ *
+ *   -t time_format     strptime format of the time at the beginning of a record,
+ *                      "%Y-%m-%d %H:%M:%S" by default; fractional seconds after it
+ *                      (".123" or ",123456") are taken into account
+ *   -o output          output file, stdout by default
+ *
+ * A line that doesn't start with the time continues the previous record.
+ * Records with the same time keep the order of the files in the arguments.
+ */
+#include <ctime>
+#include <queue>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+/**
+ * @brief Time of a record: seconds and nanoseconds.
+ * 
+ */
+struct TimeKey
+{
+    int64_t seconds = 0;
+    long nanoseconds = 0;
+
+    bool operator > (const TimeKey &rhs) const
+    {
+        return seconds != rhs.seconds ? seconds > rhs.seconds : nanoseconds > rhs.nanoseconds;
+    }
+};
+
+/**
+ * @brief Reader of a file, keeps the current record.
+ * 
+ */
+struct Shard
+{
+    size_t index = 0;
+    std::ifstream stream;
+    std::string record;
+    TimeKey key;
+    std::string next_line;
+    bool has_next_line = false;
+};
+
+static void usage()
+{
+    std::cerr 
+        << "Usage: log_merge [-t time_format] [-o output] file..."
+        << std::endl;
+}
+
+/**
+ * @brief Parses the time at the beginning of the line.
+ * 
+ * @param line 
+ * @param format    strptime format
+ * @param key       parsed time
+ * @return true if the line starts with the time
+ */
+static bool parse_time(const std::string &line, const char *format, TimeKey &key)
+{
+    std::tm tm{};
+    const char *end = strptime(line.c_str(), format, &tm);
+    if (!end) {
+        return false;
+    }
+    key.seconds = static_cast<int64_t>(timegm(&tm));
+    key.nanoseconds = 0;
+    if (*end == '.' || *end == ',') {
+        long scale = 100000000;
+        for (++end; *end >= '0' && *end <= '9'; ++end) {
+            key.nanoseconds += (*end - '0') * scale;
+            scale /= 10;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reads the next record of the file with its continuation lines.
+ * 
+ * @param shard 
+ * @param format 
+ * @return false at the end of the file
+ */
+static bool read_record(Shard &shard, const char *format)
+{
+    if (!shard.has_next_line && !std::getline(shard.stream, shard.next_line)) {
+        return false;
+    }
+    shard.record = std::move(shard.next_line);
+    shard.has_next_line = false;
+
+    TimeKey key;
+    if (parse_time(shard.record, format, key)) {
+        shard.key = key;
+    }
+    shard.record.push_back('\n');
+
+    std::string line;
+    while (std::getline(shard.stream, line)) {
+        if (parse_time(line, format, key)) {
+            shard.next_line = std::move(line);
+            shard.has_next_line = true;
+            break;
+        }
+        shard.record.append(line);
+        shard.record.push_back('\n');
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string time_format = "%Y-%m-%d %H:%M:%S";
+    std::string output;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:o:")) != -1) {
+        switch (opt) {
+            case 't': time_format = optarg; break;
+            case 'o': output = optarg; break;
+            default: usage(); return 1;
+        }
+    }
+    if (optind >= argc) {
+        usage();
+        return 1;
+    }
+
+    std::ofstream output_file;
+    if (!output.empty()) {
+        output_file.open(output, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!output_file.is_open()) {
+            std::cerr << "Can't open output file: " << output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = output.empty() ? std::cout : output_file;
+    std::ios::sync_with_stdio(false);
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    auto later = [&shards](size_t a, size_t b) {
+        if (shards[a]->key > shards[b]->key) {
+            return true;
+        }
+        return !(shards[b]->key > shards[a]->key) && a > b;
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(later)> queue(later);
+
+    for (int i = optind; i < argc; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->index = shards.size();
+        shard->stream.open(argv[i], std::ios::in | std::ios::binary);
+        if (!shard->stream.is_open()) {
+            std::cerr << "Can't open file: " << argv[i] << std::endl;
+            return 1;
+        }
+        shards.push_back(std::move(shard));
+        if (read_record(*shards.back(), time_format.c_str())) {
+            queue.push(shards.back()->index);
+        }
+    }
+
+    // k-way merge: the earliest current record of the files goes out first
+    while (!queue.empty()) {
+        size_t index = queue.top();
+        queue.pop();
+        Shard &shard = *shards[index];
+        out.write(shard.record.data(), static_cast<std::streamsize>(shard.record.length()));
+        if (read_record(shard, time_format.c_str())) {
+            queue.push(index);
+        }
+    }
+
+    out.flush();
+    return out ? 0 : 1;
+}
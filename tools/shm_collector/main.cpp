@@ -0,0 +1,181 @@
+/*
+ * Collector of shared-memory rings written by ShmRingSink.
+ *
+ * Drains the rings and writes their records through FileSink:
+ *
+ *   shm_collector [-p prefix] [-n max_files] [-s max_file_size] [-i interval_ms] [-u]
+ *                 file_template [ring_name...]
+ *
+ *   -p prefix          collect all rings whose names start with the prefix (/dev/shm is scanned)
+ *   -n max_files       maximum number of files
+ *   -s max_file_size   maximum file size in bytes, the template must contain %i
+ *   -i interval_ms     polling interval, 50 ms by default
+ *   -u                 remove the rings on exit
+ */
+#include <logging/sink/file.h>
+#include <logging/sink/shm_ring.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <unistd.h>
+
+using namespace logging;
+
+static volatile std::sig_atomic_t stop_requested = 0;
+
+static void on_signal(int)
+{
+    stop_requested = 1;
+}
+
+/**
+ * @brief Record read from a ring, passed to FileSink.
+ * 
+ */
+struct CollectedRecord : public ILogRecordData
+{
+    const RingRecord &record;
+
+    CollectedRecord(const RingRecord &record) : record(record) { }
+
+    virtual const char* get_data() const override { return record.text.c_str(); }
+    virtual int64_t get_data_length(bool) const override { return static_cast<int64_t>(record.text.length()); }
+    virtual LogLevel get_level() const override { return record.level; }
+    virtual int64_t get_time() const override { return record.time; }
+    virtual const char* get_file_name() const override { return ""; }
+    virtual int get_line_number() const override { return 0; }
+};
+
+static void usage()
+{
+    std::cerr 
+        << "Usage: shm_collector [-p prefix] [-n max_files] [-s max_file_size] [-i interval_ms] [-u] "
+        << "file_template [ring_name...]"
+        << std::endl;
+}
+
+/**
+ * @brief Returns names of the shared memory objects with the prefix.
+ * 
+ * @param prefix 
+ * @return std::set<std::string> 
+ */
+static std::set<std::string> find_rings(const std::string &prefix)
+{
+    std::set<std::string> names;
+    std::string name_prefix = prefix[0] == '/' ? prefix.substr(1) : prefix;
+    std::error_code code;
+    for (auto &p : std::filesystem::directory_iterator("/dev/shm", code)) {
+        auto name = p.path().filename().string();
+        if (name.compare(0, name_prefix.length(), name_prefix) == 0) {
+            names.insert("/" + name);
+        }
+    }
+    return names;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string prefix;
+    unsigned int max_files = 0;
+    uint64_t max_file_size = 0;
+    unsigned int interval_ms = 50;
+    bool unlink_rings = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:n:s:i:u")) != -1) {
+        switch (opt) {
+            case 'p': prefix = optarg; break;
+            case 'n': max_files = static_cast<unsigned int>(std::stoul(optarg)); break;
+            case 's': max_file_size = std::stoull(optarg); break;
+            case 'i': interval_ms = static_cast<unsigned int>(std::stoul(optarg)); break;
+            case 'u': unlink_rings = true; break;
+            default: usage(); return 1;
+        }
+    }
+    if (optind >= argc) {
+        usage();
+        return 1;
+    }
+
+    std::unique_ptr<FileSink> file_sink;
+    try {
+        file_sink = std::make_unique<FileSink>(argv[optind], max_files);
+        if (max_file_size) {
+            file_sink->set_max_file_size(max_file_size);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    file_sink->set_flush_policy({256 * 1024, interval_ms, LogLevel::FATAL});
+
+    std::set<std::string> names(argv + optind + 1, argv + argc);
+    std::map<std::string, std::unique_ptr<ShmRingReader>> readers;
+    std::map<std::string, uint64_t> lost_bytes;
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    std::vector<RingRecord> records;
+    bool stopping = false;
+    while (!stopping) {
+        // the last pass drains the rings after the stop request
+        stopping = stop_requested;
+
+        if (!prefix.empty()) {
+            auto found = find_rings(prefix);
+            names.insert(found.begin(), found.end());
+        }
+        for (auto &name : names) {
+            if (!readers.count(name)) {
+                auto reader = std::make_unique<ShmRingReader>(name);
+                if (reader->is_open()) {
+                    readers.emplace(name, std::move(reader));
+                }
+            }
+        }
+
+        records.clear();
+        for (auto &[name, reader] : readers) {
+            reader->read(records);
+            uint64_t lost = reader->get_lost_bytes();
+            if (lost != lost_bytes[name]) {
+                std::cerr 
+                    << "Ring " << name << " overrun, lost bytes: " << lost - lost_bytes[name]
+                    << std::endl;
+                lost_bytes[name] = lost;
+            }
+        }
+
+        // records of different rings are merged by time
+        std::stable_sort(records.begin(), records.end(), [](const RingRecord &a, const RingRecord &b) {
+            return a.time < b.time;
+        });
+        for (auto &record : records) {
+            CollectedRecord data{record};
+            file_sink->write(&data, nullptr);
+        }
+
+        if (!stopping && records.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+        }
+    }
+
+    file_sink->flush();
+    if (unlink_rings) {
+        for (auto &[name, reader] : readers) {
+            ShmRingReader::remove(name);
+        }
+    }
+    return 0;
+}